@@ -22,15 +22,19 @@ KExiv2::KExiv2()
 }
 
 KExiv2::KExiv2(const KExiv2& metadata)
-    : d(new KExiv2Private)
+    : d(new KExiv2Private(metadata.d->data))
 {
     d->copyPrivateData(metadata.d.get());
 }
 
+KExiv2::KExiv2(KExiv2&& metadata) noexcept
+    : d(std::move(metadata.d))
+{
+}
+
 KExiv2::KExiv2(const KExiv2Data& data)
-    : d(new KExiv2Private)
+    : d(data.d ? new KExiv2Private(data.d) : new KExiv2Private)
 {
-    setData(data);
 }
 
 KExiv2::KExiv2(const QString& filePath)
@@ -41,9 +45,30 @@ KExiv2::KExiv2(const QString& filePath)
 
 KExiv2::~KExiv2() = default;
 
+KExiv2::PrivatePointer::~PrivatePointer()
+{
+    delete p;
+}
+
+KExiv2Private* KExiv2::PrivatePointer::create() const
+{
+    // The moved-from container is used again, as a new one.
+    p = new KExiv2Private;
+
+    return p;
+}
+
 KExiv2& KExiv2::operator=(const KExiv2& metadata)
 {
     d->copyPrivateData(metadata.d.get());
+    d->clearUndoHistory();
+
+    return *this;
+}
+
+KExiv2& KExiv2::operator=(KExiv2&& metadata) noexcept
+{
+    d.swap(metadata.d);
 
     return *this;
 }
@@ -196,15 +221,165 @@ void KExiv2::setData(const KExiv2Data& data)
     {
         // KExiv2Data can have a null pointer,
         // but we never want a null pointer in Private.
-        d->data->clear();
+        d->data = KExiv2DataPrivate::empty();
+    }
+
+    d->clearUndoHistory();
+}
+
+void KExiv2::reset()
+{
+    d->reset();
+}
+
+void KExiv2::beginEdit() const
+{
+    if (d->editDepth++ > 0)
+        return;
+
+    d->editIptcCharsetSet = d->iptcCharset(d->editIptcCharset);
+
+    if (d->undoLimit > 0)
+    {
+        d->undoStack << d->data;
+    }
+}
+
+bool KExiv2::commitEdit() const
+{
+    if (d->editDepth == 0)
+    {
+        qCDebug(LIBKEXIV2_LOG) << "commitEdit() called without beginEdit()";
+        return false;
+    }
+
+    if (--d->editDepth > 0)
+        return true;
+
+    bool ok = true;
+
+    if (d->pendingProgramId)
+    {
+        d->pendingProgramId = false;
+        ok                  = setProgramId(true);
+    }
+
+    std::string charset;
+
+    // A character set the caller set or removed during the edit is kept.
+
+    if (d->pendingIptcCharset && d->iptcCharset(charset) == d->editIptcCharsetSet && charset == d->editIptcCharset)
+    {
+        try
+        {
+            d->setIptcCharsetUtf8();
+        }
+        catch( Exiv2::Error& e )
+        {
+            d->printExiv2ExceptionError(QString::fromLatin1("Cannot set Iptc character set using Exiv2 "), e);
+            ok = false;
+        }
+        catch(...)
+        {
+            qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+            ok = false;
+        }
+    }
+
+    d->pendingIptcCharset = false;
+
+    // Do not keep an undo step for an edit which changed nothing. The setters detach the
+    // metadata even when they only read them, so compare the blocks, not the snapshots.
+
+    if (d->undoLimit > 0 && !d->undoStack.isEmpty())
+    {
+        if (d->data.constData()->sharesBlocks(*d->undoStack.constLast().constData()))
+        {
+            d->data = d->undoStack.takeLast();
+        }
+        else
+        {
+            d->redoStack.clear();
+
+            if (d->undoStack.size() > d->undoLimit)
+            {
+                d->undoStack.removeFirst();
+            }
+        }
+    }
+
+    return ok;
+}
+
+bool KExiv2::isEditing() const
+{
+    return (d->editDepth > 0);
+}
+
+void KExiv2::setUndoLimit(int steps)
+{
+    d->undoLimit = qMax(steps, 0);
+
+    while (d->undoStack.size() > d->undoLimit)
+    {
+        d->undoStack.removeFirst();
+    }
+
+    if (d->undoLimit == 0)
+    {
+        d->redoStack.clear();
     }
 }
 
+int KExiv2::undoLimit() const
+{
+    return d->undoLimit;
+}
+
+bool KExiv2::canUndo() const
+{
+    return !d->undoStack.isEmpty();
+}
+
+bool KExiv2::canRedo() const
+{
+    return !d->redoStack.isEmpty();
+}
+
+bool KExiv2::undo()
+{
+    if (d->undoStack.isEmpty() || d->editDepth > 0)
+        return false;
+
+    d->redoStack << d->data;
+    d->data = d->undoStack.takeLast();
+
+    return true;
+}
+
+bool KExiv2::redo()
+{
+    if (d->redoStack.isEmpty() || d->editDepth > 0)
+        return false;
+
+    d->undoStack << d->data;
+    d->data = d->redoStack.takeLast();
+
+    return true;
+}
+
+void KExiv2::clearUndoHistory()
+{
+    d->clearUndoHistory();
+}
+
 bool KExiv2::loadFromData(const QByteArray& imgData) const
 {
     if (imgData.isEmpty())
         return false;
 
+    d->clearUndoHistory();
+
     try
     {
 #if EXIV2_TEST_VERSION(0,28,0)
@@ -265,6 +440,8 @@ bool KExiv2::load(const QString& filePath) const
     d->filePath      = filePath;
     bool hasLoaded   = false;
 
+    d->clearUndoHistory();
+
     try
     {
 #if EXIV2_TEST_VERSION(0,28,0)
@@ -528,4 +705,39 @@ bool KExiv2::setProgramId(bool /*on*/) const
     return true;
 }
 
+bool KExiv2::applyProgramId(bool on) const
+{
+    if (d->editDepth > 0)
+    {
+        d->pendingProgramId |= on;
+        return true;
+    }
+
+    return setProgramId(on);
+}
+
+// -------------------------------------------------------------------------------------------
+
+KExiv2::EditTransaction::EditTransaction(const KExiv2& container)
+    : metadata(&container)
+{
+    container.beginEdit();
+}
+
+KExiv2::EditTransaction::~EditTransaction()
+{
+    commit();
+}
+
+bool KExiv2::EditTransaction::commit()
+{
+    if (!metadata)
+        return false;
+
+    const bool ok = metadata->commitEdit();
+    metadata      = nullptr;
+
+    return ok;
+}
+
 }  // NameSpace KExiv2Iface
@@ -11,10 +11,12 @@
 // Std
 
 #include <memory>
+#include <utility>
 
 // QT includes
 
 #include <QByteArray>
+#include <QByteArrayView>
 #include <QString>
 #include <QDateTime>
 #include <QMap>
@@ -23,6 +25,7 @@
 #include <QVariant>
 #include <QUrl>
 #include <QImage>
+#include <QRectF>
 
 // Local includes
 
@@ -44,6 +47,9 @@
 namespace KExiv2Iface
 {
 
+class RotationMatrix;
+class KExiv2Private;
+
 /*!
  * \class KExiv2Iface::KExiv2
  * \inmodule KExiv2
@@ -133,6 +139,18 @@ public:
         ArraySeqTag             = 4
     };
 
+    /*! Search modes used to query the tags catalogue with searchTagsList().
+     * \value PREFIX_SEARCH
+     *        Match the tags where the key, the name or the title starts with the searched text.
+     * \value SUBSTRING_SEARCH
+     *        Match the tags where the key, the name or the title contains the searched text.
+     */
+    enum TagsSearchMode
+    {
+        PREFIX_SEARCH    = 0,
+        SUBSTRING_SEARCH = 1
+    };
+
     /*! A map used to store Tags Key and Tags Value.
      */
     typedef QMap<QString, QString> MetaDataMap;
@@ -153,6 +171,111 @@ public:
      */
     typedef QMap<QString, QStringList> TagsMap;
 
+    /*! All GPS information of an image, decoded at once with gpsRecord().
+     *
+     *  Each value comes with a flag telling if it was found in the metadata.
+     *  The coordinates are in degrees, where the sign determines the direction ref
+     *  (North + / South - ; East + / West -), and the altitude in meters relative to sea level.
+     *  Speed, track and image direction keep the Exif reference of their unit
+     *  ('K', 'M' or 'N' for the speed, 'T' or 'M' for the directions).
+     */
+    struct GPSRecord
+    {
+        bool      hasLatitude       = false;
+        bool      hasLongitude      = false;
+        bool      hasAltitude       = false;
+        bool      hasDop            = false;
+        bool      hasSpeed          = false;
+        bool      hasTrack          = false;
+        bool      hasImgDirection   = false;
+
+        double    latitude          = 0.0;
+        double    longitude         = 0.0;
+        double    altitude          = 0.0;
+        double    dop               = 0.0;
+        double    speed             = 0.0;
+        double    track             = 0.0;
+        double    imgDirection      = 0.0;
+
+        char      speedRef          = 'K';
+        char      trackRef          = 'T';
+        char      imgDirectionRef   = 'T';
+
+        /*! The UTC date and time of the GPS fix. Invalid if not available.
+         */
+        QDateTime timeStamp;
+
+        /*! The geodetic survey data used by the receiver, as "WGS-84".
+         */
+        QString   mapDatum;
+
+        /*! Returns \c true if the record has a position.
+         */
+        bool isValid() const { return (hasLatitude && hasLongitude); }
+    };
+
+    /*! A MWG region of the image, as a face, read and written at once with
+     *  getFaceRegions() and setFaceRegions().
+     *
+     *  The area is normalized to the image size, from (0, 0) at the top left corner
+     *  to (1, 1) at the bottom right one. It is null if the region has no area, or if
+     *  its area uses another unit.
+     */
+    struct FaceRegion
+    {
+        QString name;
+
+        /*! The MWG region type: "Face", "Pet", "Focus" or "BarCode". Empty if the region
+         *  has no type.
+         */
+        QString type;
+
+        QRectF  area;
+
+        /*! The position of the region in the list returned by getFaceRegions(), or -1
+         *  for a new region. setFaceRegions() copies the fields of this region which are
+         *  not described here, as mwg-rs:Description, mwg-rs:Rotation or the extensions,
+         *  and its area if it is null here and uses another unit than normalized.
+         */
+        int     index = -1;
+    };
+
+    /*!
+     * \class KExiv2Iface::KExiv2::EditTransaction
+     * \inmodule KExiv2
+     * \inheaderfile KExiv2/KExiv2
+     *
+     * \brief Groups the changes made to a KExiv2 container during its lifetime.
+     *
+     * The constructor calls beginEdit(), and commit() or the destructor calls commitEdit().
+     */
+    class LIBKEXIV2_EXPORT EditTransaction
+    {
+    public:
+
+        /*!
+         * Starts a group of changes on \a container, which must outlive the transaction.
+         */
+        explicit EditTransaction(const KExiv2& container);
+
+        /*!
+         * Commits the changes if commit() has not been called.
+         */
+        ~EditTransaction();
+
+        /*!
+         * Commits the changes now. Returns the result of KExiv2::commitEdit(), or \c false if
+         * the transaction is already committed.
+         */
+        bool commit();
+
+    private:
+
+        const KExiv2* metadata;
+
+        Q_DISABLE_COPY(EditTransaction)
+    };
+
 public:
 
     /*! Standard constructor.
@@ -163,6 +286,11 @@ public:
      */
     KExiv2(const KExiv2& metadata);
 
+    /*! Move constructor. The metadata and settings of \a metadata are moved to the new
+     *  container without any allocation, and \a metadata is left as a newly constructed one.
+     */
+    KExiv2(KExiv2&& metadata) noexcept;
+
     /*! Constructor to load from parsed \a data.
      */
     KExiv2(const KExiv2Data& data);
@@ -179,6 +307,10 @@ public:
      */
     KExiv2& operator=(const KExiv2& metadata);
 
+    /*! Move assignment. The metadata of this container are moved to \a metadata.
+     */
+    KExiv2& operator=(KExiv2&& metadata) noexcept;
+
 public:
 
     //-----------------------------------------------------------------
@@ -256,6 +388,75 @@ public:
      */
     void setData(const KExiv2Data& data);
 
+    /*! Resets the container to the state of a newly constructed one: removes all metadata,
+     *  clears the file path and restores the default settings. Reusing a container with reset()
+     *  in a loop avoids the allocations of a new one for each file.
+     */
+    void reset();
+
+    /*! Starts a group of changes. Until the matching commitEdit(), the side effects
+     *  of the setters are deferred: setProgramId() is called once, and the IPTC
+     *  character set is set to UTF-8 once, by the outermost commitEdit(). A character
+     *  set changed explicitly with Iptc.Envelope.CharacterSet during the edit is kept.
+     *
+     *  The calls can be nested. Use EditTransaction to pair them automatically.
+     */
+    void beginEdit() const;
+
+    /*! Ends a group of changes started with beginEdit(), and applies the deferred side
+     *  effects if it is the outermost one.
+     *
+     *  Returns \c false if there is no group of changes to end or if the side effects fail.
+     */
+    bool commitEdit() const;
+
+    /*! Returns \c true between beginEdit() and the matching commitEdit().
+     */
+    bool isEditing() const;
+
+    /*! Sets the maximum number of undo steps kept, or disables the history if \a steps is 0,
+     *  which is the default.
+     *
+     *  With the history enabled, each outermost beginEdit() records an undo step, dropped by
+     *  commitEdit() if the edit changed nothing. Only these transactions are recorded: a setter
+     *  called outside beginEdit() and commitEdit() changes the metadata without an undo step,
+     *  so wrap single changes in an EditTransaction to make them undoable.
+     *
+     *  A step is a snapshot of the metadata which shares the unchanged Exif, IPTC, XMP and
+     *  comments blocks with the current ones: only the blocks changed during the edit take
+     *  memory. The history is cleared when metadata are loaded, or replaced with setData()
+     *  or an assignment.
+     */
+    void setUndoLimit(int steps);
+    /*!
+     */
+    int  undoLimit() const;
+
+    /*! Returns \c true if an edit can be undone.
+     */
+    bool canUndo() const;
+
+    /*! Returns \c true if an undone edit can be redone.
+     */
+    bool canRedo() const;
+
+    /*! Restores the metadata as they were before the last recorded edit (see setUndoLimit()),
+     *  in constant time.
+     *
+     *  Returns \c false if there is nothing to undo or if an edit is in progress.
+     */
+    bool undo();
+
+    /*! Restores the metadata as they were before the last undo(), in constant time.
+     *
+     *  Returns \c false if there is nothing to redo or if an edit is in progress.
+     */
+    bool redo();
+
+    /*! Removes all undo and redo steps.
+     */
+    void clearUndoHistory();
+
     /*! Load all metadata (Exif, IPTC, XMP, and JFIF Comments) from a byte array.
      *
      *  Returns \c true if the metadata has been loaded successfully from \a imgData.
@@ -399,6 +600,18 @@ public:
      */
     bool setImageOrientation(ImageOrientation orientation, bool setProgramName=true) const;
 
+    /*! Changes the metadata as if the image pixels were rotated to the normal orientation.
+     *
+     * The Exif thumbnail and the IPTC preview are rotated, the image dimensions are swapped
+     * for the transpositions, the MWG regions are transformed with transformXmpRegions(), and
+     * the orientation is reset to normal with setImageOrientation().
+     *
+     * Returns the transformation the caller has to apply to the pixels, as with
+     * rotateExifQImage(). If the image is already in the normal orientation, or if one of
+     * the steps fails, the metadata are left unchanged and the identity is returned.
+     */
+    RotationMatrix normalizeOrientation(bool setProgramName=true) const;
+
     /*! Returns the image color-space set in Exif metadata.
      *
      *  The makernotes of the image are also parsed to get this information.
@@ -439,20 +652,65 @@ public:
      */
     QDateTime getDigitizationDateTime(bool fallbackToCreationTime=false) const;
 
+    /*! Converts an Exif ("YYYY:MM:DD HH:MM:SS") or XMP (ISO 8601) date and time string to a QDateTime.
+     *
+     *  The milliseconds from an Exif \a subSecTime value and the time zone from an Exif
+     *  \a offsetTime value ("+hh:mm") are merged in the result. Other string formats are
+     *  delegated to QDateTime::fromString() with Qt::ISODate.
+     *
+     *  Returns an invalid QDateTime if the string cannot be parsed.
+     */
+    static QDateTime convertFromDateTimeString(const QString& dateTime,
+                                               const QString& subSecTime=QString(),
+                                               const QString& offsetTime=QString());
+
+    /*! Batch version of convertFromDateTimeString(), to convert whole columns of date and time strings.
+     *
+     *  \a subSecTimes and \a offsetTimes can be empty, else their items are merged with the
+     *  \a dateTimes items at the same position.
+     */
+    static QList<QDateTime> convertFromDateTimeStrings(const QStringList& dateTimes,
+                                                       const QStringList& subSecTimes=QStringList(),
+                                                       const QStringList& offsetTimes=QStringList());
+
     /*! Returns a QImage copy of the IPTC \a preview image.
      *
      * Returns a null image if the preview cannot be found.
      */
     bool getImagePreview(QImage& preview) const;
 
+    /*! Returns the best thumbnail for the \a targetSize, from the images embedded in the
+     *  metadata or in the file: the Exif thumbnail, the IPTC preview and the previews listed
+     *  by KExiv2Previews. The smallest image at least as large as \a targetSize is used, or the
+     *  largest one if none is large enough.
+     *
+     *  The image is scaled down while decoding to fit in \a targetSize, keeping the aspect
+     *  ratio, and rotated according to the Exif orientation. If \a targetSize is not valid,
+     *  the largest image is returned at full size.
+     *
+     *  Returns a null image if no embedded image can be found.
+     */
+    QImage bestThumbnail(const QSize& targetSize) const;
+
+    /*! Encodes the \a image in JPEG, with the highest quality up to \a maxQuality for which the
+     *  data fit in \a maxSize bytes. The quality is found with a bounded binary search, reusing
+     *  the same buffer for all encodings. The chosen quality is returned in \a quality if not null.
+     *
+     *  Returns an empty byte array if the image is still too large at a low quality: it must be
+     *  scaled down.
+     */
+    static QByteArray encodeJpeg(const QImage& image, int maxSize, int maxQuality=75, int* const quality=nullptr);
+
     /*! Sets the IPTC \a preview image.
      *
      *  The thumbnail image must have the right size prior to this operation
-     *  (64Kb max with JPEG file, else 256Kb).
+     *  (64Kb max with JPEG file, else 256Kb). The JPEG quality is lowered as needed
+     *  to fit these limits, see encodeJpeg().
      *
      *  Look at the IPTC specification for details.
      *
-     *  Returns \c true if the preview has been changed in the metadata.
+     *  Returns \c true if the preview has been changed in the metadata, \c false if
+     *  the preview does not fit the limits even at a low quality.
      *
      *  Re-implement this method if you want to use an image file format other than JPEG to
      *  save the preview.
@@ -567,19 +825,45 @@ public:
      */
     bool rotateExifQImage(QImage& image, ImageOrientation orientation) const;
 
+    /*! Writes to \a output the \a image with its orientation fixed according to the Exif
+     *  \a orientation tag. The pixels of \a output are reused if it already has the size
+     *  of the rotated image and the format of \a image, else a new image is allocated.
+     *
+     *  32 and 8 bits images are rotated by dedicated kernels, other formats
+     *  through QImage::transformed().
+     *
+     *  Returns \c true if the image is rotated. Returns \c false and leaves \a output
+     *  unchanged if there is nothing to do.
+     */
+    bool rotateExifQImage(const QImage& image, QImage& output, ImageOrientation orientation) const;
+
     /*! Sets the Exif Thumbnail image.
      *
      * The thumbnail image must have the right dimensions prior to this operation.
+     * With JPEG files, the JPEG quality is lowered as needed for the Exif data, thumbnail
+     * included, to fit in the 64 KB APP1 segment, see encodeJpeg().
      *
      * Look at the Exif specification for details.
      *
-     * Returns \c true if the thumbnail has been changed in the metadata.
+     * Returns \c true if the thumbnail has been changed in the metadata, \c false if
+     * the thumbnail does not fit in the segment even at a low quality.
      */
     bool setExifThumbnail(const QImage& thumb, bool setProgramName=true) const;
 
     /*! Remove the Exif thumbnail from the image. */
     bool removeExifThumbnail() const;
 
+    /*! Rotates the Exif thumbnail according to its Exif.Thumbnail.Orientation tag,
+     *  and resets the tag to normal.
+     *
+     *  When the library is built with TurboJPEG, JPEG thumbnails are rotated losslessly
+     *  in the DCT domain, as jpegtran does, unless their size is not a multiple of
+     *  the JPEG blocks size. Else the thumbnail is decoded, rotated and encoded again.
+     *
+     *  Returns \c true if the thumbnail is rotated, or if there is nothing to do.
+     */
+    bool normalizeExifThumbnailOrientation(bool setProgramName=true) const;
+
     /*! Adds a JPEG thumbnail \a thumb to TIFF images.
      *
      * Use this instead of setExifThumbnail() for TIFF images.
@@ -652,6 +936,20 @@ public:
      */
     QByteArray getExifTagData(const char* exifTagName) const;
 
+    /*! Gets a view on the Exif tag content \a exifTagName, without copying it from
+     * the Exiv2 value. Only text values (Ascii tags, except comments) can be viewed:
+     * use getExifTagData() for the other ones.
+     *
+     * The view points into the metadata block of this object, which can be shared with
+     * copies, KExiv2Data instances and undo steps. It stays valid until this object is
+     * destroyed or its metadata are changed by a setter, load(), setData(), reset(),
+     * undo() or redo(): then the block can be released by its last other owner at any
+     * time. The getters never change the metadata.
+     *
+     * Returns a null view if the Exif tag cannot be found or is not a text value.
+     */
+    QByteArrayView getExifTagDataView(const char* exifTagName) const;
+
     /*! Sets an Exif tag content \a exifTagName using a byte array \a data.
      *
      * Returns \c true if the tag is set successfully.
@@ -815,6 +1113,20 @@ public:
      */
     QByteArray getIptcTagData(const char* iptcTagName) const;
 
+    /*! Gets a view on the IPTC tag content \a iptcTagName, without copying it from
+     * the Exiv2 value. Only string datasets can be viewed: use getIptcTagData() for
+     * the binary, numeric, date and time ones.
+     *
+     * The view points into the metadata block of this object, which can be shared with
+     * copies, KExiv2Data instances and undo steps. It stays valid until this object is
+     * destroyed or its metadata are changed by a setter, load(), setData(), reset(),
+     * undo() or redo(): then the block can be released by its last other owner at any
+     * time. The getters never change the metadata.
+     *
+     * Returns a null view if the IPTC tag cannot be found or is not a string.
+     */
+    QByteArrayView getIptcTagDataView(const char* iptcTagName) const;
+
     /*! Sets an IPTC tag content \a iptcTagName using a byte array \a data.
      *
      * Returns \c true if tag is set successfully.
@@ -877,6 +1189,19 @@ public:
     bool setIptcKeywords(const QStringList& oldKeywords, const QStringList& newKeywords,
                          bool setProgramName=true) const;
 
+    /*! Adds the IPTC \a keywords which are not present yet in the image. The existing
+     *  keywords are left untouched.
+     *
+     * Returns \c true if the keywords are present in the metadata.
+     */
+    bool addIptcKeywords(const QStringList& keywords, bool setProgramName=true) const;
+
+    /*! Removes the IPTC \a keywords from the image. The other keywords are left untouched.
+     *
+     * Returns \c true if the keywords are no longer present in the metadata.
+     */
+    bool removeIptcKeywords(const QStringList& keywords, bool setProgramName=true) const;
+
     /*! Returns a strings list of IPTC subjects from the image.
      *
      * Returns an empty list if no subjects are set.
@@ -1077,10 +1402,11 @@ public:
 
     /*! Sets an XMP tag content \a xmpTagName using a list of strings defined by the \a entriesToAdd.
      *
-     *  The existing entries are preserved.
+     *  The existing entries are preserved in place, and the new entries are appended.
      *
      *  This method will compare all new entries with all already existing entries
-     *  to prevent duplicates in the image.
+     *  to prevent duplicates in the image. The comparison uses a hash of the entries,
+     *  and the bag is not written if nothing changes.
      *
      *  Returns \c true if the entries have been added to metadata.
      */
@@ -1096,6 +1422,29 @@ public:
     bool removeFromXmpTagStringBag(const char* xmpTagName, const QStringList& entriesToRemove,
                                    bool setProgramName) const;
 
+    /*! Same as addToXmpTagStringBag(), for the XMP seq \a xmpTagName. The order of
+     *  the existing entries is preserved.
+     */
+    bool addToXmpTagStringSeq(const char* xmpTagName, const QStringList& entriesToAdd,
+                              bool setProgramName=true) const;
+
+    /*! Same as removeFromXmpTagStringBag(), for the XMP seq \a xmpTagName. The order of
+     *  the other entries is preserved.
+     */
+    bool removeFromXmpTagStringSeq(const char* xmpTagName, const QStringList& entriesToRemove,
+                                   bool setProgramName=true) const;
+
+    /*! Removes \a entriesToRemove from and adds \a entriesToAdd to the XMP bag \a xmpTagName
+     *  of all containers in \a metadata, as removeFromXmpTagStringBag() and addToXmpTagStringBag().
+     *
+     *  The entries are hashed and the key is parsed once for all containers.
+     *
+     *  Returns the number of containers changed.
+     */
+    static int editXmpTagStringBag(const QList<KExiv2*>& metadata, const char* xmpTagName,
+                                   const QStringList& entriesToAdd, const QStringList& entriesToRemove,
+                                   bool setProgramName=true);
+
     /*! Gets an XMP tag content \a xmpTagName as a QVariant.
      *
      *  Returns a null QVariant if the XMP tag cannot be found.
@@ -1188,6 +1537,36 @@ public:
      */
     bool removeXmpTag(const char* xmpTagName, bool setProgramName=true) const;
 
+    /*! Rewrites the areas of all MWG regions (Xmp.mwg-rs.Regions), as the face regions,
+     *  after the image pixels have been transformed as rotateExifQImage() does with \a transform.
+     *
+     *  All normalized areas are read and transformed in one pass. The areas using another
+     *  unit are left unchanged. With a transposition, the applied-to dimensions are swapped too.
+     *
+     *  Returns \c true if the regions have been transformed or if there are none.
+     */
+    bool transformXmpRegions(ImageOrientation transform, bool setProgramName=true) const;
+
+    /*! Returns the MWG regions (Xmp.mwg-rs.Regions) of the image, in the order of the region list.
+     *
+     *  All regions are decoded in one pass over the XMP metadata. The areas which are not
+     *  normalized are returned as null rectangles.
+     */
+    QList<FaceRegion> getFaceRegions() const;
+
+    /*! Replaces all MWG regions (Xmp.mwg-rs.Regions) of the image by \a regions in one operation.
+     *  If \a regions is empty, the regions structure is removed.
+     *
+     *  The regions read with getFaceRegions() keep the fields FaceRegion does not describe,
+     *  found with FaceRegion::index in the current regions. The metadata must not have been
+     *  changed since getFaceRegions().
+     *
+     *  The applied-to dimensions are set to getImageDimensions() if they are not present yet.
+     *
+     *  Returns \c true if the regions have been changed in the metadata.
+     */
+    bool setFaceRegions(const QList<FaceRegion>& regions, bool setProgramName=true) const;
+
 
     /*! Registers a namespace which Exiv2 doesn't know yet.
      *
@@ -1205,6 +1584,28 @@ public:
 
     //@}
 
+    //------------------------------------------------------------
+    /// @name Tags catalogue methods
+    //@{
+
+    /*! Returns a map of the Exif, makernote, IPTC and XMP tags supported by Exiv2 whose key,
+     *  name or title matches \a text, using the search \a mode.
+     *
+     *  The comparison is case insensitive. If \a maxResults is positive, the search stops
+     *  once this number of tags has been found.
+     *
+     *  The search index is built on the first call and shared by all instances,
+     *  so the queries are fast enough to be used while the user types. It is built
+     *  again on the next call after an XMP namespace is registered or unregistered.
+     *
+     *  The map values are the same as with getStdExifTagsList().
+     *  \sa TagsSearchMode
+     */
+    KExiv2::TagsMap searchTagsList(const QString& text, TagsSearchMode mode=PREFIX_SEARCH,
+                                   int maxResults=-1) const;
+
+    //@}
+
     //------------------------------------------------------------
     /// @name GPS manipulation methods
     //@{
@@ -1219,6 +1620,15 @@ public:
      */
     bool getGPSInfo(double& altitude, double& latitude, double& longitude) const;
 
+    /*! Gets all GPS information set in the image: position, altitude, timestamp, speed,
+     *  track, image direction, DOP and map datum.
+     *
+     *  The whole GPS IFD is decoded in a single pass, and the XMP GPS tags have the
+     *  priority, as with the other GPS methods. This is the fastest way to get more than
+     *  one GPS value.
+     */
+    GPSRecord gpsRecord() const;
+
     /*! Gets GPS location information set in the image, in the GPSCoordinate format
      *  as described in the XMP specification.
      *
@@ -1286,6 +1696,12 @@ public:
     static void convertToRational(const double number, long int* const numerator,
                                   long int* const denominator, const int rounding);
 
+    /*! Batch version of convertToRational(), to convert \a count \a numbers at once with the same
+     *  \a rounding precision. The results are the same as with convertToRational().
+     */
+    static void convertToRationals(const double* const numbers, long int* const numerators,
+                                   long int* const denominators, const int count, const int rounding);
+
     /*! Converts a \a number to a rational value, returned in the \a numerator and
      *  \a denominator parameters.
      *
@@ -1312,6 +1728,20 @@ public:
      */
     static QString convertToGPSCoordinateString(const bool isLatitude, double coordinate);
 
+    /*! Same as convertToGPSCoordinateString(const bool, double), without memory allocation:
+     *  the GPSCoordinate string is written to the \a buffer of \a size chars, with a
+     *  terminating null char. A buffer of 20 chars is always large enough.
+     *
+     *  Returns the length of the string, or 0 if the coordinate is invalid or the buffer too small.
+     */
+    static int convertToGPSCoordinateString(const bool isLatitude, double coordinate,
+                                            char* const buffer, const int size);
+
+    /*! Batch version of convertToGPSCoordinateString(const bool, double), to convert a list of
+     *  \a coordinates of the same kind. Invalid coordinates give null strings.
+     */
+    static QStringList convertToGPSCoordinateStrings(const bool isLatitude, const QList<double>& coordinates);
+
     /*! Converts a GPSCoordinate string as defined by XMP to three rationals and the direction reference.
      *
      *  Returns \c true if the conversion was successful.
@@ -1331,6 +1761,16 @@ public:
      */
     static bool convertFromGPSCoordinateString(const QString& gpsString, double* const coordinate);
 
+    /*! Same as convertFromGPSCoordinateString(const QString&, double* const), working on the
+     *  \a size first chars of the Latin-1 string \a gpsString, without memory allocation.
+     */
+    static bool convertFromGPSCoordinateString(const char* const gpsString, const int size, double* const coordinate);
+
+    /*! Batch version of convertFromGPSCoordinateString(const QString&, double* const), to convert
+     *  a list of GPSCoordinate strings. Strings which cannot be converted give NaN values.
+     */
+    static QList<double> convertFromGPSCoordinateStrings(const QStringList& gpsStrings);
+
     /*! Converts a GPSCoordinate string to user presentable numbers, integer degrees and minutes and
      *  double floating point seconds, and a direction reference ('N' or 'S', 'E' or 'W').
      */
@@ -1363,14 +1803,85 @@ protected:
 
 private:
 
+    /*! Calls setProgramId(), or defers it to commitEdit() between beginEdit() and commitEdit().
+     */
+    bool applyProgramId(bool on) const;
+
+    /*! Removes \a entriesToRemove from and adds \a entriesToAdd to the XMP array \a xmpTagName
+     *  of the Exiv2 \a type xmpBag or xmpSeq.
+     */
+    bool editXmpTagStringArray(const char* xmpTagName, int type, const QStringList& entriesToAdd,
+                               const QStringList& entriesToRemove, bool setProgramName) const;
+
+    /*! Same as setGPSInfo(), with the absolute \a altitude already converted to the rational
+     *  \a altitudeNumerator / \a altitudeDenominator, as done for many images at once by
+     *  convertToRationals().
+     */
+    bool setGPSInfo(const double* const altitude, long int altitudeNumerator, long int altitudeDenominator,
+                    const double latitude, const double longitude, const bool setProgramName);
+
+    /*! Owns the private members of a container. A moved-from container owns none until
+     *  its next use, which creates them: moving allocates nothing and cannot throw.
+     * \internal
+     */
+    class LIBKEXIV2_EXPORT PrivatePointer
+    {
+    public:
+
+        explicit PrivatePointer(KExiv2Private* const priv = nullptr) noexcept
+            : p(priv)
+        {
+        }
+
+        PrivatePointer(PrivatePointer&& other) noexcept
+            : p(other.p)
+        {
+            other.p = nullptr;
+        }
+
+        ~PrivatePointer();
+
+        KExiv2Private* get() const
+        {
+            return (p ? p : create());
+        }
+
+        KExiv2Private* operator->() const
+        {
+            return get();
+        }
+
+        KExiv2Private& operator*() const
+        {
+            return *get();
+        }
+
+        void swap(PrivatePointer& other) noexcept
+        {
+            std::swap(p, other.p);
+        }
+
+    private:
+
+        Q_DISABLE_COPY(PrivatePointer)
+
+        KExiv2Private* create() const;
+
+    private:
+
+        mutable KExiv2Private* p;
+    };
+
     /*! Internal container to store private members.
      *
      * Used to improve binary compatibility.
      * \internal
      */
-    std::unique_ptr<class KExiv2Private> const d;
+    PrivatePointer d;
 
     friend class KExiv2Previews;
+    friend class KExiv2KeywordTree;
+    friend class KExiv2GPSCorrelator;
 };
 
 }  // NameSpace KExiv2Iface
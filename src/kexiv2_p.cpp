@@ -20,9 +20,22 @@ extern "C"
 #endif
 }
 
+// C++ includes
+
+#include <algorithm>
+
 // Qt includes
+#include <QBuffer>
+#include <QImageReader>
+#include <QSet>
 #include <QStringDecoder>
 
+// TurboJPEG includes
+
+#ifdef HAVE_TURBOJPEG
+#   include <turbojpeg.h>
+#endif
+
 // Local includes
 
 #include "libkexiv2_debug.h"
@@ -41,18 +54,110 @@ extern "C"
 namespace KExiv2Iface
 {
 
+QAtomicInt KExiv2Private::xmpNamespacesRevision;
+
+/** Installs the Exiv2 message handler once, not for each KExiv2 instance.
+ */
+static void installExiv2MessageHandler()
+{
+    static const bool installed = []()
+        {
+            Exiv2::LogMsg::setHandler(KExiv2Private::printExiv2MessageHandler);
+            return true;
+        }();
+
+    Q_UNUSED(installed);
+}
+
 KExiv2Private::KExiv2Private()
-    : data(new KExiv2DataPrivate)
+    : KExiv2Private(KExiv2DataPrivate::empty())
+{
+}
+
+KExiv2Private::KExiv2Private(const QSharedDataPointer<KExiv2DataPrivate>& sharedData)
+    : writeRawFiles(false),
+      updateFileTimeStamp(false),
+      useXMPSidecar4Reading(false),
+      metadataWritingMode(KExiv2::WRITETOIMAGEONLY),
+      loadedFromSidecar(false),
+      editDepth(0),
+      pendingProgramId(false),
+      pendingIptcCharset(false),
+      editIptcCharsetSet(false),
+      undoLimit(0),
+      data(sharedData)
+{
+    installExiv2MessageHandler();
+}
+
+KExiv2Private::~KExiv2Private() = default;
+
+void KExiv2Private::reset()
 {
     writeRawFiles         = false;
     updateFileTimeStamp   = false;
     useXMPSidecar4Reading = false;
     metadataWritingMode   = KExiv2::WRITETOIMAGEONLY;
     loadedFromSidecar     = false;
-    Exiv2::LogMsg::setHandler(KExiv2Private::printExiv2MessageHandler);
+    data                  = KExiv2DataPrivate::empty();
+
+    editDepth             = 0;
+    pendingProgramId      = false;
+    pendingIptcCharset    = false;
+    editIptcCharsetSet    = false;
+    undoLimit             = 0;
+
+    editIptcCharset.clear();
+
+    clearUndoHistory();
+    filePath.clear();
+    pixelSize = QSize();
+    mimeType.clear();
 }
 
-KExiv2Private::~KExiv2Private() = default;
+void KExiv2Private::clearUndoHistory()
+{
+    undoStack.clear();
+    redoStack.clear();
+}
+
+void KExiv2Private::setIptcCharsetUtf8()
+{
+    if (editDepth > 0)
+    {
+        pendingIptcCharset = true;
+        return;
+    }
+
+    iptcMetadata()["Iptc.Envelope.CharacterSet"] = "\33%G";
+}
+
+bool KExiv2Private::iptcCharset(std::string& value) const
+{
+    value.clear();
+
+    try
+    {
+        const Exiv2::IptcData& iptcData    = iptcMetadata();
+        Exiv2::IptcData::const_iterator it = iptcData.findKey(Exiv2::IptcKey("Iptc.Envelope.CharacterSet"));
+
+        if (it != iptcData.end())
+        {
+            value = it->toString();
+            return true;
+        }
+    }
+    catch( Exiv2::Error& e )
+    {
+        printExiv2ExceptionError(QString::fromLatin1("Cannot get Iptc character set using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+    return false;
+}
 
 void KExiv2Private::copyPrivateData(const KExiv2Private* const other)
 {
@@ -350,13 +455,40 @@ bool KExiv2Private::saveOperations(const QFileInfo& finfo, Exiv2::Image::AutoPtr
     return false;
 }
 
+KExiv2DataPrivate::KExiv2DataPrivate()
+    : imageComments(KExiv2DataBlock<std::string>::empty()),
+      exifMetadata(KExiv2DataBlock<Exiv2::ExifData>::empty()),
+      iptcMetadata(KExiv2DataBlock<Exiv2::IptcData>::empty())
+#ifdef _XMP_SUPPORT_
+      , xmpMetadata(KExiv2DataBlock<Exiv2::XmpData>::empty())
+#endif
+{
+}
+
+const QSharedDataPointer<KExiv2DataPrivate>& KExiv2DataPrivate::empty()
+{
+    static const QSharedDataPointer<KExiv2DataPrivate> data(new KExiv2DataPrivate);
+    return data;
+}
+
+bool KExiv2DataPrivate::sharesBlocks(const KExiv2DataPrivate& other) const
+{
+    return (imageComments == other.imageComments &&
+            exifMetadata  == other.exifMetadata  &&
+            iptcMetadata  == other.iptcMetadata
+#ifdef _XMP_SUPPORT_
+            && xmpMetadata == other.xmpMetadata
+#endif
+           );
+}
+
 void KExiv2DataPrivate::clear()
 {
-    imageComments.clear();
-    exifMetadata.clear();
-    iptcMetadata.clear();
+    imageComments = KExiv2DataBlock<std::string>::empty();
+    exifMetadata  = KExiv2DataBlock<Exiv2::ExifData>::empty();
+    iptcMetadata  = KExiv2DataBlock<Exiv2::IptcData>::empty();
 #ifdef _XMP_SUPPORT_
-    xmpMetadata.clear();
+    xmpMetadata   = KExiv2DataBlock<Exiv2::XmpData>::empty();
 #endif
 }
 
@@ -377,47 +509,157 @@ void KExiv2Private::printExiv2MessageHandler(int lvl, const char* msg)
     qCDebug(LIBKEXIV2_LOG) << "Exiv2 (" << lvl << ") : " << msg;
 }
 
+bool KExiv2Private::transformJpegLossless(const QByteArray& data, KExiv2::ImageOrientation orientation,
+                                          QByteArray& output)
+{
+#ifdef HAVE_TURBOJPEG
+
+    tjtransform transform;
+    memset(&transform, 0, sizeof(transform));
+
+    switch (orientation)
+    {
+        case KExiv2::ORIENTATION_HFLIP:
+            transform.op = TJXOP_HFLIP;
+            break;
+        case KExiv2::ORIENTATION_ROT_180:
+            transform.op = TJXOP_ROT180;
+            break;
+        case KExiv2::ORIENTATION_VFLIP:
+            transform.op = TJXOP_VFLIP;
+            break;
+        case KExiv2::ORIENTATION_ROT_90_HFLIP:
+            transform.op = TJXOP_TRANSPOSE;
+            break;
+        case KExiv2::ORIENTATION_ROT_90:
+            transform.op = TJXOP_ROT90;
+            break;
+        case KExiv2::ORIENTATION_ROT_90_VFLIP:
+            transform.op = TJXOP_TRANSVERSE;
+            break;
+        case KExiv2::ORIENTATION_ROT_270:
+            transform.op = TJXOP_ROT270;
+            break;
+        default:
+            return false;
+    }
+
+    // Fail instead of dropping or smearing the partial blocks on the edges, and drop the
+    // markers: a thumbnail has no use for them.
+    transform.options = TJXOPT_PERFECT | TJXOPT_COPYNONE;
+
+    tjhandle handle = tjInitTransform();
+
+    if (!handle)
+        return false;
+
+    unsigned char* buffer = nullptr;
+    unsigned long  size   = 0;
+    const bool     ok     = (tjTransform(handle, reinterpret_cast<const unsigned char*>(data.constData()),
+                                         (unsigned long)data.size(), 1, &buffer, &size, &transform, 0) == 0);
+
+    if (ok)
+    {
+        output = QByteArray(reinterpret_cast<const char*>(buffer), (qsizetype)size);
+    }
+    else
+    {
+        qCDebug(LIBKEXIV2_LOG) << "Cannot transform JPEG data losslessly:" << tjGetErrorStr2(handle);
+    }
+
+    tjFree(buffer);
+    tjDestroy(handle);
+
+    return ok;
+
+#else
+
+    Q_UNUSED(data);
+    Q_UNUSED(orientation);
+    Q_UNUSED(output);
+
+    return false;
+
+#endif
+}
+
+QImage KExiv2Private::loadScaledImage(const QByteArray& data, const QSize& targetSize, const QByteArray& format)
+{
+    if (data.isEmpty())
+        return QImage();
+
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImageReader reader(&buffer, format);
+
+    if (targetSize.isValid())
+    {
+        const QSize size = reader.size();
+
+        if (size.isValid() && (size.width() > targetSize.width() || size.height() > targetSize.height()))
+        {
+            reader.setScaledSize(size.scaled(targetSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1)));
+        }
+    }
+
+    QImage image = reader.read();
+
+    if (image.isNull() && !format.isEmpty())
+    {
+        // Wrong format hint: let Qt probe the data.
+
+        return loadScaledImage(data, targetSize);
+    }
+
+    return image;
+}
+
 QString KExiv2Private::convertCommentValue(const Exiv2::Exifdatum& exifDatum) const
 {
     try
     {
-        std::string comment;
-        std::string charset;
-
-        comment = exifDatum.toString();
+        const std::string value = exifDatum.toString();
+        const char* comment     = value.data();
+        size_t size             = cStringLength(comment, value.size());
+        size_t charsetSize      = 0;
 
         // libexiv2 will prepend "charset=\"SomeCharset\" " if charset is specified
-        // Before conversion to QString, we must know the charset, so we stay with std::string for a while
-        if (comment.length() > 8 && comment.substr(0, 8) == "charset=")
+        // Before conversion to QString, we must know the charset, so we stay with raw bytes for a while
+        if (size > 8 && value.compare(0, 8, "charset=") == 0)
         {
             // the prepended charset specification is followed by a blank
-            std::string::size_type pos = comment.find_first_of(' ');
+            const char* const blank = static_cast<const char*>(memchr(comment, ' ', size));
 
-            if (pos != std::string::npos)
+            if (blank)
             {
-                // extract string between the = and the blank
-                charset = comment.substr(8, pos-8);
-                // get the rest of the string after the charset specification
-                comment = comment.substr(pos+1);
+                // the charset is the string between the = and the blank,
+                // the comment is the rest of the string after the charset specification
+                charsetSize = blank - comment - 8;
+                size       -= blank + 1 - comment;
+                comment     = blank + 1;
             }
         }
 
-        if (charset == "\"Unicode\"")
+        if (charsetSize && value.compare(8, charsetSize, "\"Unicode\"") == 0)
         {
-            return QString::fromUtf8(comment.data());
+            return QString::fromUtf8(comment, size);
         }
-        else if (charset == "\"Jis\"")
+        else if (charsetSize && value.compare(8, charsetSize, "\"Jis\"") == 0)
         {
-            QStringDecoder codec("JIS7");
-            return codec.decode(comment.c_str());
+            // Creating a decoder is expensive, keep one per thread and reset it between uses.
+            static thread_local QStringDecoder codec("JIS7");
+            codec.resetState();
+            return codec.decode(QByteArrayView(comment, size));
         }
-        else if (charset == "\"Ascii\"")
+        else if (charsetSize && value.compare(8, charsetSize, "\"Ascii\"") == 0)
         {
-            return QString::fromLatin1(comment.c_str());
+            return QString::fromLatin1(comment, size);
         }
         else
         {
-            return detectEncodingAndDecode(comment);
+            return detectEncodingAndDecode(comment, size);
         }
     }
     catch( Exiv2::Error& e )
@@ -432,7 +674,127 @@ QString KExiv2Private::convertCommentValue(const Exiv2::Exifdatum& exifDatum) co
     return QString();
 }
 
+QString KExiv2Private::convertIptcValue(const Exiv2::Iptcdatum& iptcDatum, bool utf8) const
+{
+    const Exiv2::StringValueBase* const str = dynamic_cast<const Exiv2::StringValueBase*>(&iptcDatum.value());
+
+    if (str)
+    {
+        const size_t size = cStringLength(str->value_.data(), str->value_.size());
+
+        return (utf8 ? QString::fromUtf8(str->value_.data(), size)
+                     : QString::fromLatin1(str->value_.data(), size));
+    }
+
+    const std::string value = iptcDatum.toString();
+    const size_t size       = cStringLength(value.data(), value.size());
+
+    return (utf8 ? QString::fromUtf8(value.data(), size)
+                 : QString::fromLatin1(value.data(), size));
+}
+
+QByteArray KExiv2Private::iptcRawValue(const Exiv2::Iptcdatum& iptcDatum)
+{
+    const Exiv2::StringValueBase* const str = dynamic_cast<const Exiv2::StringValueBase*>(&iptcDatum.value());
+
+    if (str)
+    {
+        return QByteArray::fromRawData(str->value_.data(), cStringLength(str->value_.data(), str->value_.size()));
+    }
+
+    const std::string value = iptcDatum.toString();
+
+    return QByteArray(value.data(), cStringLength(value.data(), value.size()));
+}
+
+int KExiv2Private::editIptcStringList(const Exiv2::IptcKey& key, int maxSize, const QStringList& removed,
+                                      const QStringList& added, bool skipExisting)
+{
+    if (removed.isEmpty() && added.isEmpty())
+        return 0;
+
+    const uint16_t record     = key.record();
+    const uint16_t tag        = key.tag();
+    Exiv2::IptcData& iptcData = iptcMetadata();
+    int count                 = 0;
+
+    // Remove the old values, compacting the container in one pass.
+
+    if (!removed.isEmpty())
+    {
+        QSet<QByteArray> removedSet;
+        removedSet.reserve(removed.size());
+
+        for (const QString& value : removed)
+        {
+            removedSet.insert(value.toUtf8());
+        }
+
+        const Exiv2::IptcData::iterator end = std::remove_if(iptcData.begin(), iptcData.end(),
+            [record, tag, &removedSet](const Exiv2::Iptcdatum& datum)
+            {
+                return (datum.record() == record && datum.tag() == tag && removedSet.contains(iptcRawValue(datum)));
+            });
+
+        const long erased = iptcData.end() - end;
+
+        for (long i = 0 ; i < erased ; ++i)
+        {
+            iptcData.erase(iptcData.end() - 1);
+        }
+
+        count += erased;
+    }
+
+    // Append the new values.
+
+    QSet<QByteArray> existing;
+
+    if (skipExisting)
+    {
+        for (Exiv2::IptcData::const_iterator it = iptcData.begin(); it != iptcData.end(); ++it)
+        {
+            if (it->record() == record && it->tag() == tag)
+            {
+                const QByteArray value = iptcRawValue(*it);
+                existing.insert(QByteArray(value.constData(), value.size()));
+            }
+        }
+    }
+
+    Exiv2::StringValue val;
+
+    for (const QString& value : added)
+    {
+        const QByteArray utf8 = value.left(maxSize).toUtf8();
+
+        if (skipExisting)
+        {
+            if (existing.contains(utf8))
+                continue;
+
+            existing.insert(utf8);
+        }
+
+        val.read(std::string(utf8.constData(), utf8.size()));
+        iptcData.add(key, &val);
+        ++count;
+    }
+
+    return count;
+}
+
 QString KExiv2Private::detectEncodingAndDecode(const std::string& value) const
+{
+    if (value.empty())
+    {
+        return QString();
+    }
+
+    return detectEncodingAndDecode(value.data(), cStringLength(value.data(), value.size()));
+}
+
+QString KExiv2Private::detectEncodingAndDecode(const char* const buffer, size_t size) const
 {
     // For charset autodetection, we could use sophisticated code
     // (Mozilla chardet, KHTML's autodetection, QTextCodec::codecForContent),
@@ -440,14 +802,16 @@ QString KExiv2Private::detectEncodingAndDecode(const std::string& value) const
     // We check for UTF8, Local encoding and ASCII.
     // Look like KEncodingDetector class can provide a full implementation for encoding detection.
 
-    if (value.empty())
+    if (!buffer)
     {
         return QString();
     }
 
-    if (isUtf8(value.c_str()))
+    size = cStringLength(buffer, size);
+
+    if (isUtf8(buffer, size))
     {
-        return QString::fromUtf8(value.c_str());
+        return QString::fromUtf8(buffer, size);
     }
 
     // Utf8 has a pretty unique byte pattern.
@@ -455,12 +819,52 @@ QString KExiv2Private::detectEncodingAndDecode(const std::string& value) const
     // to reliably autodetect different ISO-8859 charsets.
     // So we can use either local encoding, or latin1.
 
-    return QString::fromLocal8Bit(value.c_str());
+    return QString::fromLocal8Bit(buffer, size);
+}
+
+size_t KExiv2Private::cStringLength(const char* const buffer, size_t size)
+{
+    const void* const nul = memchr(buffer, 0, size);
+
+    return (nul ? static_cast<const char*>(nul) - buffer : size);
 }
 
-bool KExiv2Private::isUtf8(const char* const buffer) const
+/** Returns true if the 16 bytes at buffer are printable 7-bit ASCII characters, which need no further
+ *  check in isUtf8(). Blocks with control characters or 8-bit bytes are left to the scalar code.
+ */
+static inline bool isPrintableAsciiBlock(const char* const buffer)
 {
-    int i, n;
+#if defined(KEXIV2_HAVE_SSE2)
+
+    const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer));
+
+    // As signed values, the bytes >= 0x80 are negative and are caught by the first comparison.
+    const __m128i low   = _mm_cmplt_epi8(chars, _mm_set1_epi8(0x20));
+    const __m128i del   = _mm_cmpeq_epi8(chars, _mm_set1_epi8(0x7F));
+
+    return (_mm_movemask_epi8(_mm_or_si128(low, del)) == 0);
+
+#elif defined(KEXIV2_HAVE_NEON)
+
+    const uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t*>(buffer));
+
+    // Printable characters are in the [0x20, 0x7E] range, (c - 0x20) wraps around for all others.
+    const uint8x16_t bad   = vcgeq_u8(vsubq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8(0x5F));
+
+    return (vmaxvq_u8(bad) == 0);
+
+#else
+
+    Q_UNUSED(buffer);
+
+    return false;
+
+#endif
+}
+
+bool KExiv2Private::isUtf8(const char* const buffer, size_t size) const
+{
+    size_t i, n;
     unsigned char c;
     bool gotone = false;
 
@@ -499,8 +903,34 @@ bool KExiv2Private::isUtf8(const char* const buffer) const
             I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I   // 0xfX
     };
 
-    for (i = 0; (c = buffer[i]); ++i)
+    // The vectorized path skips the runs of printable ASCII 16 bytes at a time. When a block
+    // needs the scalar code, the next block check is done once the scalar code has passed it,
+    // to not test every byte of non Latin text twice.
+
+    size_t scalarEnd = 0;
+
+    for (i = 0; i < size; ++i)
     {
+#if defined(KEXIV2_HAVE_SSE2) || defined(KEXIV2_HAVE_NEON)
+        if (i >= scalarEnd)
+        {
+            if ((i + 16 <= size) && isPrintableAsciiBlock(buffer + i))
+            {
+                i += 15;
+                continue;
+            }
+
+            scalarEnd = i + 16;
+        }
+#else
+        Q_UNUSED(scalarEnd);
+#endif
+
+        c = buffer[i];
+
+        if (c == 0)
+            break;
+
         if ((c & 0x80) == 0)
         {
             // 0xxxxxxx is plain ASCII
@@ -520,7 +950,7 @@ bool KExiv2Private::isUtf8(const char* const buffer) const
         else
         {
             // 11xxxxxx begins UTF-8
-            int following = 0;
+            size_t following = 0;
 
             if ((c & 0x20) == 0)
             {
@@ -556,7 +986,7 @@ bool KExiv2Private::isUtf8(const char* const buffer) const
             {
                 i++;
 
-                if (!(c = buffer[i]))
+                if (i >= size || !(c = buffer[i]))
                     goto done;
 
                 if ((c & 0x80) == 0 || (c & 0x40))
@@ -577,6 +1007,330 @@ done:
 #undef I
 #undef X
 
+// Date and time parsing ----------------------------------------------------------------------
+
+static inline uint charCode(char c)
+{
+    return uchar(c);
+}
+
+static inline uint charCode(QChar c)
+{
+    return c.unicode();
+}
+
+template <typename Char>
+static inline bool parseDigits(const Char* const buffer, size_t count, int& value)
+{
+    value = 0;
+
+    for (size_t i = 0 ; i < count ; ++i)
+    {
+        const uint digit = charCode(buffer[i]) - '0';
+
+        if (digit > 9)
+            return false;
+
+        value = value * 10 + int(digit);
+    }
+
+    return true;
+}
+
+/** Parse the decimal digits of a fraction of second at buffer[pos] and move pos after them.
+ *  Returns the number of digits found, and the fraction rounded to milliseconds in msec.
+ */
+template <typename Char>
+static size_t parseFraction(const Char* const buffer, size_t size, size_t& pos, int& msec)
+{
+    const size_t start = pos;
+    int fraction       = 0;
+    int digits         = 0;
+
+    for ( ; pos < size && (charCode(buffer[pos]) - '0') <= 9 ; ++pos)
+    {
+        if (digits < 4)
+        {
+            fraction = fraction * 10 + int(charCode(buffer[pos]) - '0');
+            ++digits;
+        }
+    }
+
+    for ( ; digits < 4 ; ++digits)
+    {
+        fraction *= 10;
+    }
+
+    msec = qMin((fraction + 5) / 10, 999);
+
+    return (pos - start);
+}
+
+/** Parse a time zone designator, "Z", "+hh:mm", "+hhmm" or "+hh".
+ */
+template <typename Char>
+static bool parseTimeZone(const Char* const buffer, size_t size, bool& utc, int& offset)
+{
+    utc    = false;
+    offset = 0;
+
+    if (size == 1 && charCode(buffer[0]) == 'Z')
+    {
+        utc = true;
+        return true;
+    }
+
+    int hours   = 0;
+    int minutes = 0;
+    const uint sign = (size ? charCode(buffer[0]) : 0);
+
+    if ((sign != '+' && sign != '-') || size < 3 || !parseDigits(buffer + 1, 2, hours))
+        return false;
+
+    if (size == 6)
+    {
+        if (charCode(buffer[3]) != ':' || !parseDigits(buffer + 4, 2, minutes))
+            return false;
+    }
+    else if (size == 5)
+    {
+        if (!parseDigits(buffer + 3, 2, minutes))
+            return false;
+    }
+    else if (size != 3)
+    {
+        return false;
+    }
+
+    if (hours > 23 || minutes > 59)
+        return false;
+
+    offset = (hours * 3600 + minutes * 60) * (sign == '-' ? -1 : 1);
+
+    return true;
+}
+
+template <typename Char>
+static bool parseDateTimeString(const Char* const buffer, size_t size, QDateTime& dateTime)
+{
+    int year   = 0;
+    int month  = 0;
+    int day    = 0;
+    int hour   = 0;
+    int minute = 0;
+    int second = 0;
+    int msec   = 0;
+    bool utc   = false;
+    bool zone  = false;
+    int offset = 0;
+
+    // Date part, "YYYY:MM:DD" in Exif, "YYYY-MM-DD" in XMP.
+
+    if (size < 10                              ||
+        !parseDigits(buffer,     4, year)      ||
+        !parseDigits(buffer + 5, 2, month)     ||
+        !parseDigits(buffer + 8, 2, day))
+    {
+        return false;
+    }
+
+    const uint separator = charCode(buffer[4]);
+
+    if ((separator != ':' && separator != '-') || charCode(buffer[7]) != separator)
+        return false;
+
+    size_t pos = 10;
+
+    if (pos < size)
+    {
+        // Time part, "hh:mm" with optional seconds, fraction of second and time zone.
+
+        const uint timeSeparator = charCode(buffer[pos]);
+
+        if ((timeSeparator != ' ' && timeSeparator != 'T') ||
+            size < pos + 6                                 ||
+            !parseDigits(buffer + pos + 1, 2, hour)        ||
+            charCode(buffer[pos + 3]) != ':'               ||
+            !parseDigits(buffer + pos + 4, 2, minute))
+        {
+            return false;
+        }
+
+        pos += 6;
+
+        if (pos < size && charCode(buffer[pos]) == ':')
+        {
+            if (size < pos + 3 || !parseDigits(buffer + pos + 1, 2, second))
+                return false;
+
+            pos += 3;
+
+            if (pos < size && (charCode(buffer[pos]) == '.' || charCode(buffer[pos]) == ','))
+            {
+                ++pos;
+
+                if (!parseFraction(buffer, size, pos, msec))
+                    return false;
+            }
+        }
+
+        if (pos < size)
+        {
+            if (!parseTimeZone(buffer + pos, size - pos, utc, offset))
+                return false;
+
+            zone = true;
+        }
+    }
+
+    // Let QDateTime::fromString() handle the "24:00" end of day notation.
+
+    if (hour == 24)
+        return false;
+
+    const QDate date(year, month, day);
+    const QTime time(hour, minute, second, msec);
+
+    if (!date.isValid() || !time.isValid())
+    {
+        dateTime = QDateTime();
+    }
+    else if (!zone)
+    {
+        dateTime = QDateTime(date, time);
+    }
+    else
+    {
+        dateTime = QDateTime(date, time, utc ? QTimeZone(QTimeZone::UTC)
+                                             : QTimeZone::fromSecondsAheadOfUtc(offset));
+    }
+
+    return true;
+}
+
+template <typename Char>
+static QDateTime mergeDateTimeParts(const QDateTime& dateTime,
+                                    const Char* const subSec, size_t subSecSize,
+                                    const Char* const offset, size_t offsetSize)
+{
+    if (!dateTime.isValid())
+        return dateTime;
+
+    QDateTime result = dateTime;
+
+    // SubSecTime is the fraction of second as decimal digits, sometime padded with blanks.
+
+    if (subSec && subSecSize && result.time().msec() == 0)
+    {
+        size_t pos = 0;
+        int msec   = 0;
+
+        if (parseFraction(subSec, subSecSize, pos, msec))
+            result = result.addMSecs(msec);
+    }
+
+    // OffsetTime is the time zone designator of the Exif date, "+hh:mm".
+
+    if (offset && offsetSize && result.timeSpec() == Qt::LocalTime)
+    {
+        bool utc       = false;
+        int  seconds   = 0;
+
+        if (parseTimeZone(offset, offsetSize, utc, seconds))
+        {
+            result = QDateTime(result.date(), result.time(), utc ? QTimeZone(QTimeZone::UTC)
+                                                                 : QTimeZone::fromSecondsAheadOfUtc(seconds));
+        }
+    }
+
+    return result;
+}
+
+bool KExiv2Private::parseDateTime(const char* const buffer, size_t size, QDateTime& dateTime)
+{
+    return parseDateTimeString(buffer, size, dateTime);
+}
+
+bool KExiv2Private::parseDateTime(const QChar* const buffer, size_t size, QDateTime& dateTime)
+{
+    return parseDateTimeString(buffer, size, dateTime);
+}
+
+QDateTime KExiv2Private::mergeSubSecAndOffset(const QDateTime& dateTime,
+                                              const char* const subSec, size_t subSecSize,
+                                              const char* const offset, size_t offsetSize)
+{
+    return mergeDateTimeParts(dateTime, subSec, subSecSize, offset, offsetSize);
+}
+
+QDateTime KExiv2Private::mergeSubSecAndOffset(const QDateTime& dateTime,
+                                              const QChar* const subSec, size_t subSecSize,
+                                              const QChar* const offset, size_t offsetSize)
+{
+    return mergeDateTimeParts(dateTime, subSec, subSecSize, offset, offsetSize);
+}
+
+/** Returns the string of an Exiv2 value without a copy when possible, else a copy saved in storage.
+ */
+static const std::string& stringValue(const Exiv2::Value& value, std::string& storage)
+{
+    const Exiv2::StringValueBase* const str = dynamic_cast<const Exiv2::StringValueBase*>(&value);
+
+    if (str)
+        return str->value_;
+
+    const Exiv2::XmpTextValue* const xmp = dynamic_cast<const Exiv2::XmpTextValue*>(&value);
+
+    if (xmp)
+        return xmp->value_;
+
+    storage = value.toString();
+
+    return storage;
+}
+
+QDateTime KExiv2Private::convertDateTimeValue(const Exiv2::Value& value)
+{
+    std::string storage;
+    const std::string& str = stringValue(value, storage);
+    const size_t size      = cStringLength(str.data(), str.size());
+    QDateTime dateTime;
+
+    if (!parseDateTime(str.data(), size, dateTime))
+    {
+        dateTime = QDateTime::fromString(QString::fromLatin1(str.data(), size), Qt::ISODate);
+    }
+
+    return dateTime;
+}
+
+QDateTime KExiv2Private::convertExifDateTime(const Exiv2::Exifdatum& dateTime,
+                                             const Exiv2::Exifdatum* const subSec,
+                                             const Exiv2::Exifdatum* const offset)
+{
+    const QDateTime result = convertDateTimeValue(dateTime.value());
+
+    if (!result.isValid() || (!subSec && !offset))
+        return result;
+
+    std::string subSecStorage;
+    std::string offsetStorage;
+    const std::string* subSecStr = nullptr;
+    const std::string* offsetStr = nullptr;
+
+    if (subSec)
+        subSecStr = &stringValue(subSec->value(), subSecStorage);
+
+    if (offset)
+        offsetStr = &stringValue(offset->value(), offsetStorage);
+
+    return mergeSubSecAndOffset(result,
+                                subSecStr ? subSecStr->data() : nullptr,
+                                subSecStr ? cStringLength(subSecStr->data(), subSecStr->size()) : 0,
+                                offsetStr ? offsetStr->data() : nullptr,
+                                offsetStr ? cStringLength(offsetStr->data(), offsetStr->size()) : 0);
+}
+
 int KExiv2Private::getXMPTagsListFromPrefix(const QString& pf, KExiv2::TagsMap& tagsMap) const
 {
     int i = 0;
@@ -622,6 +1376,80 @@ int KExiv2Private::getXMPTagsListFromPrefix(const QString& pf, KExiv2::TagsMap&
     return i;
 }
 
+/** The maximum payload of a JPEG APP segment: 65535 bytes minus the 2 bytes of the length field.
+ */
+static const int s_jpegSegmentMaxSize = 65533;
+
+int KExiv2Private::exifThumbnailMaxSize() const
+{
+    // Encode the Exif tags without the thumbnail to know the space left in the segment. The
+    // margin is for the "Exif\0\0" header and the IFD1 entries describing the thumbnail.
+
+    static const int s_margin = 6 + 256;
+
+    try
+    {
+        Exiv2::ExifData exifData(exifMetadata());
+        Exiv2::ExifThumb thumb(exifData);
+        thumb.erase();
+
+        Exiv2::Blob blob;
+        Exiv2::ExifParser::encode(blob, Exiv2::littleEndian, exifData);
+
+        return s_jpegSegmentMaxSize - s_margin - (int)blob.size();
+    }
+    catch( Exiv2::Error& e )
+    {
+        printExiv2ExceptionError(QString::fromLatin1("Cannot encode Exif data using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+    return 0;
+}
+
+int KExiv2Private::iptcPreviewMaxSize() const
+{
+    if (mimeType != QLatin1String("image/jpeg"))
+    {
+        return 256000;
+    }
+
+    // The IPTC datasets are stored in a Photoshop resource of the APP13 segment. The margin is
+    // for the "Photoshop 3.0\0" header, the resource header and the preview dataset header.
+
+    static const int s_margin = 14 + 12 + 9 + 64;
+
+    try
+    {
+        Exiv2::IptcData iptcData(iptcMetadata());
+        Exiv2::IptcData::iterator it = iptcData.findKey(Exiv2::IptcKey("Iptc.Application2.Preview"));
+
+        if (it != iptcData.end())
+            iptcData.erase(it);
+
+        Exiv2::DataBuf const buf = Exiv2::IptcParser::encode(iptcData);
+
+#if EXIV2_TEST_VERSION(0,28,0)
+        return s_jpegSegmentMaxSize - s_margin - (int)buf.size();
+#else
+        return s_jpegSegmentMaxSize - s_margin - (int)buf.size_;
+#endif
+    }
+    catch( Exiv2::Error& e )
+    {
+        printExiv2ExceptionError(QString::fromLatin1("Cannot encode Iptc data using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+    return 0;
+}
+
 #ifdef _XMP_SUPPORT_
 #if EXIV2_TEST_VERSION(0,28,0)
 void KExiv2Private::loadSidecarData(Exiv2::Image::UniquePtr xmpsidecar)
@@ -14,6 +14,7 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <cassert>
 #include <cmath>
 #include <cfloat>
@@ -25,9 +26,22 @@
 
 #include <QFile>
 #include <QSize>
+#include <QTimeZone>
 #include <QLatin1String>
 #include <QFileInfo>
 #include <QSharedData>
+#include <QList>
+#include <QAtomicInt>
+
+// SIMD includes
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define KEXIV2_HAVE_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#   include <arm_neon.h>
+#   define KEXIV2_HAVE_NEON 1
+#endif
 
 // Exiv2 includes -------------------------------------------------------
 
@@ -62,22 +76,54 @@
 namespace KExiv2Iface
 {
 
+/** One of the metadata containers of KExiv2DataPrivate. Each container is shared on its own,
+ *  so that changing the XMP metadata of a copy only copies the XMP container, not the Exif one.
+ */
+template <class Container>
+class KExiv2DataBlock : public QSharedData
+{
+public:
+
+    /** Returns the empty block shared by all new and cleared metadata.
+     */
+    static const QSharedDataPointer<KExiv2DataBlock>& empty()
+    {
+        static const QSharedDataPointer<KExiv2DataBlock> block(new KExiv2DataBlock);
+        return block;
+    }
+
+public:
+
+    Container value;
+};
+
 class KExiv2DataPrivate : public QSharedData
 {
 public:
 
+    KExiv2DataPrivate();
+
     void clear();
 
+    /** Returns true if all metadata blocks are shared with \a other, i.e. nothing changed
+     *  between the two snapshots, even if they are distinct copies.
+     */
+    bool sharesBlocks(const KExiv2DataPrivate& other) const;
+
+    /** Returns the empty metadata shared by all new KExiv2 instances.
+     */
+    static const QSharedDataPointer<KExiv2DataPrivate>& empty();
+
 public:
 
-    std::string     imageComments;
+    QSharedDataPointer<KExiv2DataBlock<std::string> >     imageComments;
 
-    Exiv2::ExifData exifMetadata;
+    QSharedDataPointer<KExiv2DataBlock<Exiv2::ExifData> > exifMetadata;
 
-    Exiv2::IptcData iptcMetadata;
+    QSharedDataPointer<KExiv2DataBlock<Exiv2::IptcData> > iptcMetadata;
 
 #ifdef _XMP_SUPPORT_
-    Exiv2::XmpData  xmpMetadata;
+    QSharedDataPointer<KExiv2DataBlock<Exiv2::XmpData> >  xmpMetadata;
 #endif
 };
 
@@ -88,10 +134,31 @@ class KExiv2Private
 public:
 
     KExiv2Private();
+
+    /** Constructs with shared metadata, without allocating new ones.
+     */
+    explicit KExiv2Private(const QSharedDataPointer<KExiv2DataPrivate>& sharedData);
     ~KExiv2Private();
 
     void copyPrivateData(const KExiv2Private* const other);
 
+    /** Restores the state of a new instance, with the empty metadata.
+     */
+    void reset();
+
+    /** Sets the IPTC character set to UTF-8, or defers it to KExiv2::commitEdit()
+     *  while editing.
+     */
+    void setIptcCharsetUtf8();
+
+    /** Returns true and the value of Iptc.Envelope.CharacterSet in \a value if the dataset is set.
+     */
+    bool iptcCharset(std::string& value) const;
+
+    /** Removes all undo and redo steps.
+     */
+    void clearUndoHistory();
+
     bool saveToXMPSidecar(const QFileInfo& finfo)                            const;
     bool saveToFile(const QFileInfo& finfo)                                  const;
 #if EXIV2_TEST_VERSION(0,28,0)
@@ -104,30 +171,105 @@ public:
      */
     QString convertCommentValue(const Exiv2::Exifdatum& exifDatum) const;
 
+    /** Wrapper method to convert an IPTC string content to a QString, decoded as UTF-8
+     *  if \a utf8 is true, else as Latin-1. String values are decoded in place, without
+     *  a copy of the Exiv2 value.
+     */
+    QString convertIptcValue(const Exiv2::Iptcdatum& iptcDatum, bool utf8) const;
+
     /** Charset autodetection to convert a string to a QString.
+     *  As with a C string, the decoding stops at the first NUL character.
      */
     QString detectEncodingAndDecode(const std::string& value)      const;
+    QString detectEncodingAndDecode(const char* const buffer, size_t size) const;
+
+    /** UTF8 autodetection from the \a size first bytes of \a buffer.
+     *  Returns false for plain 7-bit ASCII text.
+     */
+    bool isUtf8(const char* const buffer, size_t size)             const;
 
-    /** UTF8 autodetection from a string.
+    /** Returns the length of \a buffer up to the first NUL character, or \a size if there is none.
      */
-    bool isUtf8(const char* const buffer)                          const;
+    static size_t cStringLength(const char* const buffer, size_t size);
+
+    /** Fast parser for the fixed format date and time strings used by Exif ("YYYY:MM:DD HH:MM:SS")
+     *  and XMP (ISO 8601 "YYYY-MM-DDThh:mm:ss.sss+hh:mm" and its forms without seconds, fraction
+     *  or time zone, or without time).
+     *  Returns false if the string does not use one of these formats. Else returns true, and
+     *  \a dateTime is set to the parsed value or to an invalid date if a field is out of range.
+     */
+    static bool parseDateTime(const char* const buffer, size_t size, QDateTime& dateTime);
+    static bool parseDateTime(const QChar* const buffer, size_t size, QDateTime& dateTime);
+
+    /** Returns \a dateTime with the milliseconds from a SubSecTime value (fraction digits) and
+     *  the time zone from an OffsetTime value ("+hh:mm"). Empty or blank values are ignored, as
+     *  well as the offset if \a dateTime already has a time zone.
+     */
+    static QDateTime mergeSubSecAndOffset(const QDateTime& dateTime,
+                                          const char* const subSec, size_t subSecSize,
+                                          const char* const offset, size_t offsetSize);
+    static QDateTime mergeSubSecAndOffset(const QDateTime& dateTime,
+                                          const QChar* const subSec, size_t subSecSize,
+                                          const QChar* const offset, size_t offsetSize);
+
+    /** Wrapper method to convert a date and time value to a QDateTime. The fast parser is
+     *  used for the Exif and XMP formats, QDateTime::fromString() for all others.
+     *  String values are parsed in place, without a copy of the Exiv2 value.
+     */
+    static QDateTime convertDateTimeValue(const Exiv2::Value& value);
+
+    /** Same as convertDateTimeValue(), with the SubSecTime and OffsetTime companion tags of an Exif
+     *  date merged in the result. The companion tags can be null.
+     */
+    static QDateTime convertExifDateTime(const Exiv2::Exifdatum& dateTime,
+                                         const Exiv2::Exifdatum* const subSec,
+                                         const Exiv2::Exifdatum* const offset);
 
     int getXMPTagsListFromPrefix(const QString& pf, KExiv2::TagsMap& tagsMap) const;
 
-    const Exiv2::ExifData& exifMetadata()  const { return data.constData()->exifMetadata;  }
-    const Exiv2::IptcData& iptcMetadata()  const { return data.constData()->iptcMetadata;  }
-    const std::string&     imageComments() const { return data.constData()->imageComments; }
+    /** Edits the values of the repeatable IPTC dataset \a key in one pass: removes the datasets
+     *  whose value is in \a removed, then appends the \a added values truncated to \a maxSize
+     *  characters. If \a skipExisting is true, the added values already present are not appended
+     *  again. Datasets are matched by their record and dataset numbers, and values by their UTF-8
+     *  bytes in hashed sets. Returns the number of datasets removed and appended.
+     */
+    int editIptcStringList(const Exiv2::IptcKey& key, int maxSize, const QStringList& removed,
+                           const QStringList& added, bool skipExisting);
+
+    /** Returns the byte value of an IPTC string dataset up to the first NUL character, without
+     *  a copy when possible. The result must not outlive the dataset.
+     */
+    static QByteArray iptcRawValue(const Exiv2::Iptcdatum& iptcDatum);
+
+    /** Returns the maximum size in bytes of a JPEG Exif thumbnail in a JPEG file, for the Exif
+     *  APP1 segment to stay under 64 KB with the other Exif tags. Can be negative if the other
+     *  tags use up the segment. The other formats have no such limit.
+     */
+    int exifThumbnailMaxSize() const;
+
+    /** Returns the maximum size in bytes of the IPTC preview: the IPTC APP13 segment must stay
+     *  under 64 KB with the other datasets in JPEG files, and the IIM limits it to 256000 bytes
+     *  in other files.
+     */
+    int iptcPreviewMaxSize() const;
+
+    // The const accessors never copy the metadata. The others copy the container
+    // they return if it is shared with another KExiv2 or KExiv2Data instance.
+
+    const Exiv2::ExifData& exifMetadata()  const { return data.constData()->exifMetadata.constData()->value;  }
+    const Exiv2::IptcData& iptcMetadata()  const { return data.constData()->iptcMetadata.constData()->value;  }
+    const std::string&     imageComments() const { return data.constData()->imageComments.constData()->value; }
 
 #ifdef _XMP_SUPPORT_
-    const Exiv2::XmpData&  xmpMetadata()   const { return data.constData()->xmpMetadata;   }
+    const Exiv2::XmpData&  xmpMetadata()   const { return data.constData()->xmpMetadata.constData()->value;   }
 #endif
 
-    Exiv2::ExifData&       exifMetadata()        { return data.data()->exifMetadata;       }
-    Exiv2::IptcData&       iptcMetadata()        { return data.data()->iptcMetadata;       }
-    std::string&           imageComments()       { return data.data()->imageComments;      }
+    Exiv2::ExifData&       exifMetadata()        { return data.data()->exifMetadata.data()->value;            }
+    Exiv2::IptcData&       iptcMetadata()        { return data.data()->iptcMetadata.data()->value;            }
+    std::string&           imageComments()       { return data.data()->imageComments.data()->value;           }
 
 #ifdef _XMP_SUPPORT_
-    Exiv2::XmpData&        xmpMetadata()         { return data.data()->xmpMetadata;        }
+    Exiv2::XmpData&        xmpMetadata()         { return data.data()->xmpMetadata.data()->value;             }
 
 #if EXIV2_TEST_VERSION(0,28,0)
     void loadSidecarData(Exiv2::Image::UniquePtr xmpsidecar);
@@ -148,6 +290,26 @@ public:
      */
     static void printExiv2MessageHandler(int lvl, const char* msg);
 
+    /** Incremented each time an XMP namespace is registered or unregistered. The tags catalogue
+     *  indexed by KExiv2::searchTagsList() changes with the namespaces.
+     */
+    static QAtomicInt xmpNamespacesRevision;
+
+    /** Transforms the JPEG \a data for the Exif \a orientation in the DCT domain, without
+     *  decoding and encoding it again, as jpegtran does. Returns false if the library is built
+     *  without TurboJPEG, or if the transformation cannot be lossless (partial edge blocks).
+     */
+    static bool transformJpegLossless(const QByteArray& data, KExiv2::ImageOrientation orientation,
+                                      QByteArray& output);
+
+    /** Decodes the image \a data of the given \a format ("jpeg", "png", ... or empty to probe it),
+     *  scaled down to fit in \a targetSize. The scaling is done by the image reader while decoding,
+     *  which lets the JPEG decoder skip the DCT coefficients not needed for the target size.
+     *  The image is never scaled up, and is loaded at full size if \a targetSize is not valid.
+     */
+    static QImage loadScaledImage(const QByteArray& data, const QSize& targetSize,
+                                  const QByteArray& format = QByteArray());
+
 public:
 
     bool                                           writeRawFiles;
@@ -165,6 +327,20 @@ public:
     QSize                                          pixelSize;
     QString                                        mimeType;
 
+    /// The nesting depth of KExiv2::beginEdit(), and the side effects deferred to KExiv2::commitEdit().
+    int                                            editDepth;
+    bool                                           pendingProgramId;
+    bool                                           pendingIptcCharset;
+
+    /// The IPTC character set when the outermost edit began, to keep one set by the caller during the edit.
+    bool                                           editIptcCharsetSet;
+    std::string                                    editIptcCharset;
+
+    /// The metadata before each recorded edit, and after each undone one. Unchanged blocks are shared.
+    int                                            undoLimit;
+    QList<QSharedDataPointer<KExiv2DataPrivate> >  undoStack;
+    QList<QSharedDataPointer<KExiv2DataPrivate> >  redoStack;
+
     QSharedDataPointer<KExiv2DataPrivate> data;
 };
 
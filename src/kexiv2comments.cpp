@@ -50,7 +50,7 @@ bool KExiv2::canWriteComment(const QString& filePath)
 
 bool KExiv2::hasComments() const
 {
-    return !d->imageComments().empty();
+    return !std::as_const(*d).imageComments().empty();
 }
 
 bool KExiv2::clearComments() const
@@ -60,12 +60,12 @@ bool KExiv2::clearComments() const
 
 QByteArray KExiv2::getComments() const
 {
-    return QByteArray(d->imageComments().data(), d->imageComments().size());
+    return QByteArray(std::as_const(*d).imageComments().data(), std::as_const(*d).imageComments().size());
 }
 
 QString KExiv2::getCommentsDecoded() const
 {
-    return d->detectEncodingAndDecode(d->imageComments());
+    return d->detectEncodingAndDecode(std::as_const(*d).imageComments());
 }
 
 bool KExiv2::setComments(const QByteArray& data) const
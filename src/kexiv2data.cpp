@@ -24,6 +24,11 @@ KExiv2Data::KExiv2Data(const KExiv2Data& other)
     d = other.d;
 }
 
+KExiv2Data::KExiv2Data(KExiv2Data&& other) noexcept
+    : d(std::move(other.d))
+{
+}
+
 KExiv2Data::~KExiv2Data()
 {
 }
@@ -34,4 +39,10 @@ KExiv2Data& KExiv2Data::operator=(const KExiv2Data& other)
     return *this;
 }
 
+KExiv2Data& KExiv2Data::operator=(KExiv2Data&& other) noexcept
+{
+    d.swap(other.d);
+    return *this;
+}
+
 }  // NameSpace KExiv2Iface
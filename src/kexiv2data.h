@@ -34,6 +34,9 @@ public:
     /*!
      */
     KExiv2Data(const KExiv2Data&);
+    /*!
+     */
+    KExiv2Data(KExiv2Data&&) noexcept;
     /*!
      */
     ~KExiv2Data();
@@ -41,6 +44,9 @@ public:
     /*!
      */
     KExiv2Data& operator=(const KExiv2Data&);
+    /*!
+     */
+    KExiv2Data& operator=(KExiv2Data&&) noexcept;
 
 private:
 
@@ -61,7 +61,7 @@ bool KExiv2::canWriteExif(const QString& filePath)
 
 bool KExiv2::hasExif() const
 {
-    return !d->exifMetadata().empty();
+    return !std::as_const(*d).exifMetadata().empty();
 }
 
 bool KExiv2::clearExif() const
@@ -87,10 +87,10 @@ QByteArray KExiv2::getExifEncoded(bool addExifHeader) const
 {
     try
     {
-        if (!d->exifMetadata().empty())
+        if (!std::as_const(*d).exifMetadata().empty())
         {
             QByteArray data;
-            Exiv2::ExifData& exif = d->exifMetadata();
+            const Exiv2::ExifData& exif = std::as_const(*d).exifMetadata();
             Exiv2::Blob blob;
             Exiv2::ExifParser::encode(blob, Exiv2::bigEndian, exif);
             QByteArray ba((const char*)&blob[0], blob.size());
@@ -131,7 +131,7 @@ bool KExiv2::setExif(const QByteArray& data) const
         if (!data.isEmpty())
         {
             Exiv2::ExifParser::decode(d->exifMetadata(), (const Exiv2::byte*)data.data(), data.size());
-            return (!d->exifMetadata().empty());
+            return (!std::as_const(*d).exifMetadata().empty());
         }
     }
     catch( Exiv2::Error& e )
@@ -151,12 +151,12 @@ bool KExiv2::setExif(const QByteArray& data) const
 
 KExiv2::MetaDataMap KExiv2::getExifTagsDataList(const QStringList& exifKeysFilter, bool invertSelection) const
 {
-    if (d->exifMetadata().empty())
+    if (std::as_const(*d).exifMetadata().empty())
        return MetaDataMap();
 
     try
     {
-        Exiv2::ExifData exifData = d->exifMetadata();
+        Exiv2::ExifData exifData = std::as_const(*d).exifMetadata();
         exifData.sortByKey();
 
         QString     ifDItemName;
@@ -227,11 +227,11 @@ QString KExiv2::getExifComment() const
 {
     try
     {
-        if (!d->exifMetadata().empty())
+        if (!std::as_const(*d).exifMetadata().empty())
         {
-            Exiv2::ExifData exifData(d->exifMetadata());
+            const Exiv2::ExifData& exifData(std::as_const(*d).exifMetadata());
             Exiv2::ExifKey key("Exif.Photo.UserComment");
-            Exiv2::ExifData::iterator it = exifData.findKey(key);
+            Exiv2::ExifData::const_iterator it = exifData.findKey(key);
 
             if (it != exifData.end())
             {
@@ -243,7 +243,7 @@ QString KExiv2::getExifComment() const
             }
 
             Exiv2::ExifKey key2("Exif.Image.ImageDescription");
-            Exiv2::ExifData::iterator it2 = exifData.findKey(key2);
+            Exiv2::ExifData::const_iterator it2 = exifData.findKey(key2);
 
             if (it2 != exifData.end())
             {
@@ -282,7 +282,7 @@ static bool is7BitAscii(const QString& s)
 
 bool KExiv2::setExifComment(const QString& comment, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -367,7 +367,7 @@ QString KExiv2::getExifTagDescription(const char* exifTagName)
 
 bool KExiv2::removeExifTag(const char* exifTagName, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -398,8 +398,8 @@ bool KExiv2::getExifTagRational(const char* exifTagName, long int& num, long int
     try
     {
         Exiv2::ExifKey exifKey(exifTagName);
-        Exiv2::ExifData exifData(d->exifMetadata());
-        Exiv2::ExifData::iterator it = exifData.findKey(exifKey);
+        const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
+        Exiv2::ExifData::const_iterator it = exifData.findKey(exifKey);
 
         if (it != exifData.end())
         {
@@ -423,7 +423,7 @@ bool KExiv2::getExifTagRational(const char* exifTagName, long int& num, long int
 
 bool KExiv2::setExifTagLong(const char* exifTagName, long val, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -445,7 +445,7 @@ bool KExiv2::setExifTagLong(const char* exifTagName, long val, bool setProgramNa
 
 bool KExiv2::setExifTagRational(const char* exifTagName, long int num, long int den, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -470,7 +470,7 @@ bool KExiv2::setExifTagData(const char* exifTagName, const QByteArray& data, boo
     if (data.isEmpty())
         return false;
 
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -536,7 +536,7 @@ bool KExiv2::setExifTagVariant(const char* exifTagName, const QVariant& val,
             if(!dateTime.isValid())
                 return false;
 
-            if (!setProgramId(setProgramName))
+            if (!applyProgramId(setProgramName))
                 return false;
 
             try
@@ -663,8 +663,8 @@ bool KExiv2::getExifTagLong(const char* exifTagName, long& val, int component) c
     try
     {
         Exiv2::ExifKey exifKey(exifTagName);
-        Exiv2::ExifData exifData(d->exifMetadata());
-        Exiv2::ExifData::iterator it = exifData.findKey(exifKey);
+        const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
+        Exiv2::ExifData::const_iterator it = exifData.findKey(exifKey);
 
         if (it != exifData.end() && it->count() > 0)
         {
@@ -693,15 +693,13 @@ QByteArray KExiv2::getExifTagData(const char* exifTagName) const
     try
     {
         Exiv2::ExifKey exifKey(exifTagName);
-        Exiv2::ExifData exifData(d->exifMetadata());
-        Exiv2::ExifData::iterator it = exifData.findKey(exifKey);
+        const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
+        Exiv2::ExifData::const_iterator it = exifData.findKey(exifKey);
 
         if (it != exifData.end())
         {
-            char* const s = new char[(*it).size()];
-            (*it).copy((Exiv2::byte*)s, Exiv2::bigEndian);
-            QByteArray data(s, (*it).size());
-            delete[] s;
+            QByteArray data((int)(*it).size(), Qt::Uninitialized);
+            (*it).copy((Exiv2::byte*)data.data(), Exiv2::bigEndian);
 
             return data;
         }
@@ -718,13 +716,47 @@ QByteArray KExiv2::getExifTagData(const char* exifTagName) const
     return QByteArray();
 }
 
+QByteArrayView KExiv2::getExifTagDataView(const char* exifTagName) const
+{
+    try
+    {
+        Exiv2::ExifKey exifKey(exifTagName);
+        const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
+        Exiv2::ExifData::const_iterator it = exifData.findKey(exifKey);
+
+        if (it != exifData.end())
+        {
+            // Only the text values are stored by Exiv2 as they are written in the file. Comment
+            // values are excluded: their copy() converts the byte order of Unicode comments.
+            const Exiv2::StringValueBase* const str = dynamic_cast<const Exiv2::StringValueBase*>(&(*it).value());
+
+            if (str && (*it).typeId() != Exiv2::comment)
+            {
+                return QByteArrayView(str->value_.data(), (qsizetype)str->value_.size());
+            }
+
+            qCDebug(LIBKEXIV2_LOG) << "Cannot view the data of Exif key" << exifTagName << ": not a text value";
+        }
+    }
+    catch( Exiv2::Error& e )
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot find Exif key '%1' into image using Exiv2 ").arg(QString::fromLatin1(exifTagName)), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+    return QByteArrayView();
+}
+
 QVariant KExiv2::getExifTagVariant(const char* exifTagName, bool rationalAsListOfInts, bool stringEscapeCR, int component) const
 {
     try
     {
         Exiv2::ExifKey exifKey(exifTagName);
-        Exiv2::ExifData exifData(d->exifMetadata());
-        Exiv2::ExifData::iterator it = exifData.findKey(exifKey);
+        const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
+        Exiv2::ExifData::const_iterator it = exifData.findKey(exifKey);
 
         if (it != exifData.end())
         {
@@ -774,7 +806,7 @@ QVariant KExiv2::getExifTagVariant(const char* exifTagName, bool rationalAsListO
                 case Exiv2::date:
                 case Exiv2::time:
                 {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+                    QDateTime dateTime = KExiv2Private::convertDateTimeValue(it->value());
                     return QVariant(dateTime);
                 }
                 case Exiv2::asciiString:
@@ -812,8 +844,8 @@ QString KExiv2::getExifTagString(const char* exifTagName, bool escapeCR) const
     try
     {
         Exiv2::ExifKey exifKey(exifTagName);
-        Exiv2::ExifData exifData(d->exifMetadata());
-        Exiv2::ExifData::iterator it = exifData.findKey(exifKey);
+        const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
+        Exiv2::ExifData::const_iterator it = exifData.findKey(exifKey);
 
         if (it != exifData.end())
         {
@@ -841,7 +873,7 @@ QString KExiv2::getExifTagString(const char* exifTagName, bool escapeCR) const
 
 bool KExiv2::setExifTagString(const char* exifTagName, const QString& value, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -865,12 +897,12 @@ QImage KExiv2::getExifThumbnail(bool fixOrientation) const
 {
     QImage thumbnail;
 
-    if (d->exifMetadata().empty())
+    if (std::as_const(*d).exifMetadata().empty())
        return thumbnail;
 
     try
     {
-        Exiv2::ExifThumbC thumb(d->exifMetadata());
+        Exiv2::ExifThumbC thumb(std::as_const(*d).exifMetadata());
         Exiv2::DataBuf const c1 = thumb.copy();
 #if EXIV2_TEST_VERSION(0,28,0)
         thumbnail.loadFromData(c1.c_data(), c1.size());
@@ -884,8 +916,8 @@ QImage KExiv2::getExifThumbnail(bool fixOrientation) const
             {
                 Exiv2::ExifKey key1("Exif.Thumbnail.Orientation");
                 Exiv2::ExifKey key2("Exif.Image.Orientation");
-                Exiv2::ExifData exifData(d->exifMetadata());
-                Exiv2::ExifData::iterator it = exifData.findKey(key1);
+                const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
+                Exiv2::ExifData::const_iterator it = exifData.findKey(key1);
 
                 if (it == exifData.end())
                     it = exifData.findKey(key2);
@@ -919,22 +951,341 @@ QImage KExiv2::getExifThumbnail(bool fixOrientation) const
     return thumbnail;
 }
 
+/** Copies the \a width pixels of \a src to \a dst in reverse order.
+ */
+template <typename T>
+static inline void reverseRow(T* const dst, const T* const src, int width)
+{
+    for (int x = 0 ; x < width ; ++x)
+    {
+        dst[x] = src[width - 1 - x];
+    }
+}
+
+static inline void reverseRow(quint32* const dst, const quint32* const src, int width)
+{
+    int x = 0;
+
+#if defined(KEXIV2_HAVE_SSE2)
+
+    for ( ; x + 4 <= width ; x += 4)
+    {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + width - 4 - x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3)));
+    }
+
+#elif defined(KEXIV2_HAVE_NEON)
+
+    for ( ; x + 4 <= width ; x += 4)
+    {
+        const uint32x4_t pixels = vrev64q_u32(vld1q_u32(src + width - 4 - x));
+        vst1q_u32(dst + x, vextq_u32(pixels, pixels, 2));
+    }
+
+#endif
+
+    for ( ; x < width ; ++x)
+    {
+        dst[x] = src[width - 1 - x];
+    }
+}
+
+static inline void reverseRow(quint8* const dst, const quint8* const src, int width)
+{
+    int x = 0;
+
+#if defined(KEXIV2_HAVE_SSE2)
+
+    for ( ; x + 16 <= width ; x += 16)
+    {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + width - 16 - x));
+
+        // Swap the bytes of each 16 bits word, then reverse the words.
+        pixels         = _mm_or_si128(_mm_slli_epi16(pixels, 8), _mm_srli_epi16(pixels, 8));
+        pixels         = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(0, 1, 2, 3));
+        pixels         = _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(0, 1, 2, 3));
+        pixels         = _mm_shuffle_epi32(pixels, _MM_SHUFFLE(1, 0, 3, 2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), pixels);
+    }
+
+#elif defined(KEXIV2_HAVE_NEON)
+
+    for ( ; x + 16 <= width ; x += 16)
+    {
+        const uint8x16_t pixels = vrev64q_u8(vld1q_u8(src + width - 16 - x));
+        vst1q_u8(dst + x, vextq_u8(pixels, pixels, 8));
+    }
+
+#endif
+
+    for ( ; x < width ; ++x)
+    {
+        dst[x] = src[width - 1 - x];
+    }
+}
+
+/** Transposes a tile of 4 x 4 32 bits pixels: dst[j][i] = src[i][j].
+ */
+static inline void transposeTile(const quint32* const* const src, quint32* const* const dst)
+{
+#if defined(KEXIV2_HAVE_SSE2)
+
+    const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[0]));
+    const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[1]));
+    const __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[2]));
+    const __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[3]));
+
+    const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+    const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+    const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[0]), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[1]), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[2]), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[3]), _mm_unpackhi_epi64(t2, t3));
+
+#elif defined(KEXIV2_HAVE_NEON)
+
+    const uint32x4x2_t t01 = vtrnq_u32(vld1q_u32(src[0]), vld1q_u32(src[1]));
+    const uint32x4x2_t t23 = vtrnq_u32(vld1q_u32(src[2]), vld1q_u32(src[3]));
+
+    vst1q_u32(dst[0], vcombine_u32(vget_low_u32(t01.val[0]),  vget_low_u32(t23.val[0])));
+    vst1q_u32(dst[1], vcombine_u32(vget_low_u32(t01.val[1]),  vget_low_u32(t23.val[1])));
+    vst1q_u32(dst[2], vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])));
+    vst1q_u32(dst[3], vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])));
+
+#else
+
+    for (int j = 0 ; j < 4 ; ++j)
+    {
+        for (int i = 0 ; i < 4 ; ++i)
+        {
+            dst[j][i] = src[i][j];
+        }
+    }
+
+#endif
+}
+
+/** Transposes a tile of 8 x 8 8 bits pixels: dst[j][i] = src[i][j].
+ */
+static inline void transposeTile(const quint8* const* const src, quint8* const* const dst)
+{
+#if defined(KEXIV2_HAVE_SSE2)
+
+    // Interleave bytes, then 16 bits and 32 bits words: each step doubles the transposed runs.
+    const __m128i a0 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src[0])),
+                                         _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src[1])));
+    const __m128i a1 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src[2])),
+                                         _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src[3])));
+    const __m128i a2 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src[4])),
+                                         _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src[5])));
+    const __m128i a3 = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src[6])),
+                                         _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src[7])));
+
+    const __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+    const __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+    const __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+    const __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+
+    const __m128i c0 = _mm_unpacklo_epi32(b0, b2);
+    const __m128i c1 = _mm_unpackhi_epi32(b0, b2);
+    const __m128i c2 = _mm_unpacklo_epi32(b1, b3);
+    const __m128i c3 = _mm_unpackhi_epi32(b1, b3);
+
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[0]), c0);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[1]), _mm_srli_si128(c0, 8));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[2]), c1);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[3]), _mm_srli_si128(c1, 8));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[4]), c2);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[5]), _mm_srli_si128(c2, 8));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[6]), c3);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[7]), _mm_srli_si128(c3, 8));
+
+#else
+
+    for (int j = 0 ; j < 8 ; ++j)
+    {
+        for (int i = 0 ; i < 8 ; ++i)
+        {
+            dst[j][i] = src[i][j];
+        }
+    }
+
+#endif
+}
+
+/** Size of the square tiles, in pixels, walked by the transposition: a tile
+ *  of the source and of the destination stay in the L1 cache.
+ */
+static const int s_orientationTileSize = 64;
+
+/** Writes to \a dst the pixels of \a src for the Exif \a orientation. \a dst must have the
+ *  size of the oriented image and the format of \a src. N is the size of the transposed tiles.
+ */
+template <typename T, int N>
+static void orientPixels(const uchar* const srcBits, qsizetype srcStride, int width, int height,
+                         uchar* const dstBits, qsizetype dstStride, KExiv2::ImageOrientation orientation)
+{
+    // Orientations 2 to 4 mirror the rows and/or the columns of the image. Orientations 5 to 8
+    // transpose it, then mirror: the destination pixel (x, y) is the source pixel at row
+    // R(x) and column C(y), where R and C are the identity or mirrored.
+
+    const bool transpose   = (orientation >= KExiv2::ORIENTATION_ROT_90_HFLIP);
+    const bool flipRows    = (orientation == KExiv2::ORIENTATION_ROT_180 || orientation == KExiv2::ORIENTATION_VFLIP ||
+                              orientation == KExiv2::ORIENTATION_ROT_90  || orientation == KExiv2::ORIENTATION_ROT_90_VFLIP);
+    const bool flipColumns = (orientation == KExiv2::ORIENTATION_HFLIP   || orientation == KExiv2::ORIENTATION_ROT_180 ||
+                              orientation == KExiv2::ORIENTATION_ROT_90_VFLIP || orientation == KExiv2::ORIENTATION_ROT_270);
+
+    const auto srcRow = [=](int row) -> const T*
+    {
+        return reinterpret_cast<const T*>(srcBits + (flipRows ? height - 1 - row : row) * srcStride);
+    };
+
+    const auto dstRow = [=](int row) -> T*
+    {
+        return reinterpret_cast<T*>(dstBits + row * dstStride);
+    };
+
+    if (!transpose)
+    {
+        for (int y = 0 ; y < height ; ++y)
+        {
+            if (flipColumns)
+                reverseRow(dstRow(y), srcRow(y), width);
+            else
+                memcpy(dstRow(y), srcRow(y), width * sizeof(T));
+        }
+
+        return;
+    }
+
+    // The destination has 'width' rows of 'height' pixels.
+
+    for (int ty = 0 ; ty < width ; ty += s_orientationTileSize)
+    {
+        const int yEnd = qMin(ty + s_orientationTileSize, width);
+
+        for (int tx = 0 ; tx < height ; tx += s_orientationTileSize)
+        {
+            const int xEnd = qMin(tx + s_orientationTileSize, height);
+            int y          = ty;
+
+            for ( ; y + N <= yEnd ; y += N)
+            {
+                // The N source columns of the destination rows y to y + N - 1, in memory order.
+                // When the columns are mirrored, the first one goes to the last row.
+
+                const int column = flipColumns ? width - y - N : y;
+                T* rows[N];
+
+                for (int k = 0 ; k < N ; ++k)
+                {
+                    rows[k] = dstRow(flipColumns ? y + N - 1 - k : y + k);
+                }
+
+                int x = tx;
+
+                for ( ; x + N <= xEnd ; x += N)
+                {
+                    const T* src[N];
+                    T*       dst[N];
+
+                    for (int k = 0 ; k < N ; ++k)
+                    {
+                        src[k] = srcRow(x + k) + column;
+                        dst[k] = rows[k] + x;
+                    }
+
+                    transposeTile(src, dst);
+                }
+
+                for ( ; x < xEnd ; ++x)
+                {
+                    const T* const src = srcRow(x) + column;
+
+                    for (int k = 0 ; k < N ; ++k)
+                    {
+                        rows[k][x] = src[k];
+                    }
+                }
+            }
+
+            for ( ; y < yEnd ; ++y)
+            {
+                T* const  dst    = dstRow(y);
+                const int column = flipColumns ? width - 1 - y : y;
+
+                for (int x = tx ; x < xEnd ; ++x)
+                {
+                    dst[x] = srcRow(x)[column];
+                }
+            }
+        }
+    }
+}
+
 bool KExiv2::rotateExifQImage(QImage& image, ImageOrientation orientation) const
 {
-    QTransform matrix = RotationMatrix::toTransform(orientation);
+    QImage rotated;
+
+    if (!rotateExifQImage(image, rotated, orientation))
+        return false;
+
+    image = rotated;
+
+    return true;
+}
+
+bool KExiv2::rotateExifQImage(const QImage& image, QImage& output, ImageOrientation orientation) const
+{
+    if ((orientation <= ORIENTATION_NORMAL) || (orientation > ORIENTATION_LAST_VALUE) || image.isNull())
+        return false;
+
+    // A shallow copy, in case output and image are the same object.
+    const QImage source    = image;
+    const bool   transpose = (orientation >= ORIENTATION_ROT_90_HFLIP);
+    const QSize  size      = transpose ? source.size().transposed() : source.size();
 
-    if ((orientation != ORIENTATION_NORMAL) && (orientation != ORIENTATION_UNSPECIFIED))
+    if ((source.depth() != 32) && (source.depth() != 8))
     {
-        image = image.transformed(matrix);
+        output = source.transformed(RotationMatrix::toTransform(orientation));
         return true;
     }
 
-    return false;
+    // Write in the pixels of output when it has the right size and format.
+
+    if ((output.size() != size) || (output.format() != source.format()) || (output.constBits() == source.constBits()))
+    {
+        output = QImage(size, source.format());
+
+        if (output.isNull())
+            return false;
+    }
+
+    output.setColorTable(source.colorTable());
+    output.setColorSpace(source.colorSpace());
+    output.setDotsPerMeterX(transpose ? source.dotsPerMeterY() : source.dotsPerMeterX());
+    output.setDotsPerMeterY(transpose ? source.dotsPerMeterX() : source.dotsPerMeterY());
+
+    if (source.depth() == 32)
+    {
+        orientPixels<quint32, 4>(source.constBits(), source.bytesPerLine(), source.width(), source.height(),
+                                 output.bits(), output.bytesPerLine(), orientation);
+    }
+    else
+    {
+        orientPixels<quint8, 8>(source.constBits(), source.bytesPerLine(), source.width(), source.height(),
+                                output.bits(), output.bytesPerLine(), orientation);
+    }
+
+    return true;
 }
 
 bool KExiv2::setExifThumbnail(const QImage& thumbImage, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     if (thumbImage.isNull())
@@ -945,11 +1296,28 @@ bool KExiv2::setExifThumbnail(const QImage& thumbImage, bool setProgramName) con
     try
     {
         QByteArray data;
-        QBuffer buffer(&data);
-        buffer.open(QIODevice::WriteOnly);
-        thumbImage.save(&buffer, "JPEG");
+
+        if (d->mimeType == QLatin1String("image/jpeg"))
+        {
+            // The whole Exif data, thumbnail included, must fit in the 64 KB APP1 segment.
+            data = encodeJpeg(thumbImage, d->exifThumbnailMaxSize());
+
+            if (data.isEmpty())
+            {
+                qCDebug(LIBKEXIV2_LOG) << "Exif thumbnail of" << thumbImage.size() << "pixels too large for the Exif segment";
+                return false;
+            }
+        }
+        else
+        {
+            // Other formats do not store the Exif data in a JPEG segment, there is no size limit.
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::WriteOnly);
+            thumbImage.save(&buffer, "JPEG");
+        }
+
         Exiv2::ExifThumb thumb(d->exifMetadata());
-        thumb.setJpegThumbnail((Exiv2::byte *)data.data(), data.size());
+        thumb.setJpegThumbnail((const Exiv2::byte *)data.constData(), data.size());
         return true;
     }
     catch( Exiv2::Error& e )
@@ -966,7 +1334,7 @@ bool KExiv2::setExifThumbnail(const QImage& thumbImage, bool setProgramName) con
 
 bool KExiv2::setTiffThumbnail(const QImage& thumbImage, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     removeExifThumbnail();
@@ -1060,6 +1428,75 @@ bool KExiv2::removeExifThumbnail() const
     return false;
 }
 
+bool KExiv2::normalizeExifThumbnailOrientation(bool setProgramName) const
+{
+    try
+    {
+        const Exiv2::ExifData& exifData    = std::as_const(*d).exifMetadata();
+        Exiv2::ExifData::const_iterator it = exifData.findKey(Exiv2::ExifKey("Exif.Thumbnail.Orientation"));
+
+        if (it == exifData.end() || !it->count())
+            return true;
+
+#if EXIV2_TEST_VERSION(0,28,0)
+        const long orientation = it->toUint32();
+#else
+        const long orientation = it->toLong();
+#endif
+
+        if (orientation <= ORIENTATION_NORMAL || orientation > ORIENTATION_LAST_VALUE)
+            return true;
+
+        if (!applyProgramId(setProgramName))
+            return false;
+
+        Exiv2::ExifThumbC thumb(exifData);
+        Exiv2::DataBuf const buf = thumb.copy();
+#if EXIV2_TEST_VERSION(0,28,0)
+        const QByteArray data((const char*)buf.c_data(), buf.size());
+#else
+        const QByteArray data((const char*)buf.pData_, buf.size_);
+#endif
+
+        if (data.isEmpty())
+            return false;
+
+        QByteArray rotated;
+
+        if (qstrcmp(thumb.extension(), ".jpg") == 0 &&
+            KExiv2Private::transformJpegLossless(data, (ImageOrientation)orientation, rotated))
+        {
+            Exiv2::ExifThumb(d->exifMetadata()).setJpegThumbnail((const Exiv2::byte*)rotated.constData(), rotated.size());
+        }
+        else
+        {
+            // Without TurboJPEG, or with partial blocks on the edges: decode, rotate and encode again.
+
+            QImage image;
+
+            if (!image.loadFromData(data) || !rotateExifQImage(image, (ImageOrientation)orientation) ||
+                !setExifThumbnail(image, false))
+            {
+                return false;
+            }
+        }
+
+        d->exifMetadata()["Exif.Thumbnail.Orientation"] = static_cast<uint16_t>(ORIENTATION_NORMAL);
+
+        return true;
+    }
+    catch( Exiv2::Error& e )
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot rotate Exif Thumbnail using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+    return false;
+}
+
 KExiv2::TagsMap KExiv2::getStdExifTagsList() const
 {
     try
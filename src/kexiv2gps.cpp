@@ -17,6 +17,8 @@
 
 #include <climits>
 #include <cmath>
+#include <cstring>
+#include <limits>
 
 // Local includes
 
@@ -25,91 +27,413 @@
 namespace KExiv2Iface
 {
 
-bool KExiv2::getGPSInfo(double& altitude, double& latitude, double& longitude) const
+/** Returns the degrees value of an Exif GPS coordinate stored as three rationals (degrees, minutes
+ *  and seconds), or false if it cannot be decoded.
+ */
+static bool decodeExifCoordinate(const Exiv2::Exifdatum& datum, double& coordinate)
 {
-    // Some GPS device do not set Altitude. So a valid GPS position can be with a zero value.
-    // No need to check return value.
-    getGPSAltitude(&altitude);
+    if (datum.count() != 3)
+        return false;
 
-    if (!getGPSLatitudeNumber(&latitude))
-         return false;
+    double num = (double)(datum.toRational(0).first);
+    double den = (double)(datum.toRational(0).second);
 
-    if (!getGPSLongitudeNumber(&longitude))
-         return false;
+    if (den == 0)
+        return false;
+
+    coordinate = num/den;
+
+    num = (double)(datum.toRational(1).first);
+    den = (double)(datum.toRational(1).second);
+
+    if (den == 0)
+        return false;
+
+    const double min = num/den;
+
+    if (min != -1.0)
+        coordinate = coordinate + min/60.0;
+
+    num = (double)(datum.toRational(2).first);
+    den = (double)(datum.toRational(2).second);
+
+    if (den == 0)
+    {
+        // be relaxed and accept 0/0 seconds. See #246077.
+        if (num == 0)
+            den = 1;
+        else
+            return false;
+    }
+
+    const double sec = num/den;
+
+    if (sec != -1.0)
+        coordinate = coordinate + sec/3600.0;
 
     return true;
 }
 
-bool KExiv2::getGPSLatitudeNumber(double* const latitude) const
+/** Returns the value of the first rational of an Exif datum, or false if the denominator is null.
+ */
+static bool decodeExifRational(const Exiv2::Exifdatum& datum, double& value)
+{
+    if (!datum.count())
+        return false;
+
+    const Exiv2::Rational rational = datum.toRational(0);
+
+    if (rational.second == 0)
+        return false;
+
+    value = (double)rational.first / (double)rational.second;
+
+    return true;
+}
+
+/** Returns the first character of an Exif GPS reference tag, or 0 if it is empty.
+ *  Exiv2 stores the ASCII references without a copy, so no string is created here.
+ */
+static char exifReference(const Exiv2::Exifdatum& datum)
+{
+    const Exiv2::StringValueBase* const str = dynamic_cast<const Exiv2::StringValueBase*>(&datum.value());
+
+    if (str)
+        return str->value_.empty() ? 0 : str->value_[0];
+
+    const std::string value = datum.toString();
+
+    return value.empty() ? 0 : value[0];
+}
+
+/** Returns the Exif altitude reference: 0 above sea level, 1 below.
+ *  The tag is a byte, but some writers stored it as the character '1'.
+ */
+static bool isBelowSeaLevel(const Exiv2::Exifdatum& datum)
+{
+    if (!datum.count())
+        return false;
+
+#if EXIV2_TEST_VERSION(0,28,0)
+    const long ref = (long)datum.toInt64(0);
+#else
+    const long ref = datum.toLong(0);
+#endif
+
+    return (ref == 1 || ref == '1');
+}
+
+#ifdef _XMP_SUPPORT_
+
+/** Parses a XMP rational value ("num/den"), or a plain decimal number.
+ */
+static bool decodeXmpRational(const Exiv2::Xmpdatum& datum, double& value)
+{
+    const QString str = QString::fromStdString(datum.toString());
+
+    if (str.isEmpty())
+        return false;
+
+    const int slash = str.indexOf(QLatin1Char('/'));
+    bool ok         = false;
+
+    if (slash == -1)
+    {
+        value = str.toDouble(&ok);
+
+        return ok;
+    }
+
+    const double num = QStringView(str).left(slash).toDouble(&ok);
+
+    if (!ok)
+        return false;
+
+    const double den = QStringView(str).mid(slash + 1).toDouble(&ok);
+
+    if (!ok || den == 0)
+        return false;
+
+    value = num/den;
+
+    return true;
+}
+
+#endif // _XMP_SUPPORT_
+
+KExiv2::GPSRecord KExiv2::gpsRecord() const
 {
+    GPSRecord record;
+
     try
     {
-        *latitude=0.0;
+        // Exif GPS IFD, decoded in a single pass over the Exif data.
+
+        const Exiv2::ExifData& exifData(std::as_const(*d).exifMetadata());
+
+        const Exiv2::Exifdatum* latitudeRef     = nullptr;
+        const Exiv2::Exifdatum* latitude        = nullptr;
+        const Exiv2::Exifdatum* longitudeRef    = nullptr;
+        const Exiv2::Exifdatum* longitude       = nullptr;
+        const Exiv2::Exifdatum* altitudeRef     = nullptr;
+        const Exiv2::Exifdatum* altitude        = nullptr;
+        const Exiv2::Exifdatum* timeStamp       = nullptr;
+        const Exiv2::Exifdatum* dateStamp       = nullptr;
+        const Exiv2::Exifdatum* dop             = nullptr;
+        const Exiv2::Exifdatum* speedRef        = nullptr;
+        const Exiv2::Exifdatum* speed           = nullptr;
+        const Exiv2::Exifdatum* trackRef        = nullptr;
+        const Exiv2::Exifdatum* track           = nullptr;
+        const Exiv2::Exifdatum* imgDirectionRef = nullptr;
+        const Exiv2::Exifdatum* imgDirection    = nullptr;
+        const Exiv2::Exifdatum* mapDatum        = nullptr;
+
+        for (Exiv2::ExifData::const_iterator it = exifData.begin(); it != exifData.end(); ++it)
+        {
+            // All GPS tags are below 0x0020, so the group name is only checked for these few tags.
 
-        // Try XMP first. Reason: XMP in sidecar may be more up-to-date than EXIF in original image.
-        if ( convertFromGPSCoordinateString(getXmpTagString("Xmp.exif.GPSLatitude"), latitude) )
-            return true;
+            if (it->tag() > 0x001f || it->groupName() != "GPSInfo")
+                continue;
 
-        // Now try to get the reference from Exif.
-        const QByteArray latRef = getExifTagData("Exif.GPSInfo.GPSLatitudeRef");
+            switch (it->tag())
+            {
+                case 0x0001: latitudeRef     = &(*it); break;
+                case 0x0002: latitude        = &(*it); break;
+                case 0x0003: longitudeRef    = &(*it); break;
+                case 0x0004: longitude       = &(*it); break;
+                case 0x0005: altitudeRef     = &(*it); break;
+                case 0x0006: altitude        = &(*it); break;
+                case 0x0007: timeStamp       = &(*it); break;
+                case 0x000b: dop             = &(*it); break;
+                case 0x000c: speedRef        = &(*it); break;
+                case 0x000d: speed           = &(*it); break;
+                case 0x000e: trackRef        = &(*it); break;
+                case 0x000f: track           = &(*it); break;
+                case 0x0010: imgDirectionRef = &(*it); break;
+                case 0x0011: imgDirection    = &(*it); break;
+                case 0x0012: mapDatum        = &(*it); break;
+                case 0x001d: dateStamp       = &(*it); break;
+                default:                               break;
+            }
+        }
 
-        if (!latRef.isEmpty())
+        // As with getGPSLatitudeNumber() and others, the coordinates need their reference tag.
+
+        if (latitudeRef && latitude && exifReference(*latitudeRef) &&
+            decodeExifCoordinate(*latitude, record.latitude))
+        {
+            if (exifReference(*latitudeRef) == 'S')
+                record.latitude *= -1.0;
+
+            record.hasLatitude = true;
+        }
+
+        if (longitudeRef && longitude && exifReference(*longitudeRef) &&
+            decodeExifCoordinate(*longitude, record.longitude))
+        {
+            if (exifReference(*longitudeRef) == 'W')
+                record.longitude *= -1.0;
+
+            record.hasLongitude = true;
+        }
+
+        if (altitudeRef && altitudeRef->count() && altitude &&
+            decodeExifRational(*altitude, record.altitude))
+        {
+            if (isBelowSeaLevel(*altitudeRef))
+                record.altitude *= -1.0;
+
+            record.hasAltitude = true;
+        }
+
+        if (dateStamp && timeStamp && timeStamp->count() == 3)
         {
-            Exiv2::ExifKey exifKey("Exif.GPSInfo.GPSLatitude");
-            Exiv2::ExifData exifData(d->exifMetadata());
-            Exiv2::ExifData::iterator it = exifData.findKey(exifKey);
+            QDateTime date;
+            const std::string str = dateStamp->toString();
 
-            if (it != exifData.end() && (*it).count() == 3)
+            if (KExiv2Private::parseDateTime(str.data(), KExiv2Private::cStringLength(str.data(), str.size()), date) &&
+                date.isValid())
             {
-                // Latitude decoding from Exif.
-                double num, den, min, sec;
+                double hours = 0.0;
 
-                num = (double)((*it).toRational(0).first);
-                den = (double)((*it).toRational(0).second);
+                if (decodeExifRational(*timeStamp, hours) &&
+                    timeStamp->toRational(1).second != 0 && timeStamp->toRational(2).second != 0)
+                {
+                    const double minutes = (double)timeStamp->toRational(1).first / timeStamp->toRational(1).second;
+                    const double seconds = (double)timeStamp->toRational(2).first / timeStamp->toRational(2).second;
+                    const qint64 msecs   = qRound64(((hours * 60.0 + minutes) * 60.0 + seconds) * 1000.0);
+
+                    if (msecs >= 0 && msecs < 24 * 3600 * 1000)
+                    {
+                        record.timeStamp = QDateTime(date.date(), QTime::fromMSecsSinceStartOfDay((int)msecs),
+                                                     QTimeZone(QTimeZone::UTC));
+                    }
+                }
+            }
+        }
 
-                if (den == 0)
-                    return false;
+        if (dop)
+            record.hasDop = decodeExifRational(*dop, record.dop);
 
-                *latitude = num/den;
+        if (speed && decodeExifRational(*speed, record.speed))
+        {
+            record.hasSpeed = true;
 
-                num = (double)((*it).toRational(1).first);
-                den = (double)((*it).toRational(1).second);
+            if (speedRef && exifReference(*speedRef))
+                record.speedRef = exifReference(*speedRef);
+        }
 
-                if (den == 0)
-                    return false;
+        if (track && decodeExifRational(*track, record.track))
+        {
+            record.hasTrack = true;
 
-                min = num/den;
+            if (trackRef && exifReference(*trackRef))
+                record.trackRef = exifReference(*trackRef);
+        }
 
-                if (min != -1.0)
-                    *latitude = *latitude + min/60.0;
+        if (imgDirection && decodeExifRational(*imgDirection, record.imgDirection))
+        {
+            record.hasImgDirection = true;
 
-                num = (double)((*it).toRational(2).first);
-                den = (double)((*it).toRational(2).second);
+            if (imgDirectionRef && exifReference(*imgDirectionRef))
+                record.imgDirectionRef = exifReference(*imgDirectionRef);
+        }
 
-                if (den == 0)
+        if (mapDatum)
+            record.mapDatum = QString::fromLatin1(mapDatum->toString().c_str()).trimmed();
+
+#ifdef _XMP_SUPPORT_
+
+        // XMP has the priority. Reason: XMP in sidecar may be more up-to-date than EXIF in original image.
+        // A single pass is done here too, instead of a findKey() call per tag.
+
+        const Exiv2::XmpData& xmpData(std::as_const(*d).xmpMetadata());
+        const Exiv2::Xmpdatum* xmpAltitudeRef = nullptr;
+        const Exiv2::Xmpdatum* xmpAltitude    = nullptr;
+        double                 value          = 0.0;
+
+        for (Exiv2::XmpData::const_iterator it = xmpData.begin(); it != xmpData.end(); ++it)
+        {
+            const std::string key = it->key();
+
+            if (key.compare(0, 12, "Xmp.exif.GPS") != 0)
+                continue;
+
+            const char* const tag = key.c_str() + 12;
+
+            if      (strcmp(tag, "Latitude") == 0)
+            {
+                const std::string str = it->toString();
+
+                if (convertFromGPSCoordinateString(str.data(), (int)str.size(), &value))
                 {
-                    // be relaxed and accept 0/0 seconds. See #246077.
-                    if (num == 0)
-                        den = 1;
-                    else
-                        return false;
+                    record.latitude    = value;
+                    record.hasLatitude = true;
                 }
+            }
+            else if (strcmp(tag, "Longitude") == 0)
+            {
+                const std::string str = it->toString();
+
+                if (convertFromGPSCoordinateString(str.data(), (int)str.size(), &value))
+                {
+                    record.longitude    = value;
+                    record.hasLongitude = true;
+                }
+            }
+            else if (strcmp(tag, "AltitudeRef") == 0)
+            {
+                xmpAltitudeRef = &(*it);
+            }
+            else if (strcmp(tag, "Altitude") == 0)
+            {
+                xmpAltitude = &(*it);
+            }
+            else if (strcmp(tag, "TimeStamp") == 0)
+            {
+                QDateTime dateTime = KExiv2Private::convertDateTimeValue(it->value());
+
+                if (dateTime.isValid())
+                {
+                    // GPS time is always UTC.
 
-                sec = num/den;
+                    if (dateTime.timeSpec() == Qt::LocalTime)
+                        dateTime.setTimeZone(QTimeZone(QTimeZone::UTC));
 
-                if (sec != -1.0)
-                    *latitude = *latitude + sec/3600.0;
+                    record.timeStamp = dateTime;
+                }
             }
-            else
+            else if (strcmp(tag, "DOP") == 0)
             {
-                return false;
+                if (decodeXmpRational(*it, value))
+                {
+                    record.dop    = value;
+                    record.hasDop = true;
+                }
             }
+            else if (strcmp(tag, "Speed") == 0)
+            {
+                if (decodeXmpRational(*it, value))
+                {
+                    record.speed    = value;
+                    record.hasSpeed = true;
+                }
+            }
+            else if (strcmp(tag, "SpeedRef") == 0)
+            {
+                const std::string ref = it->toString();
 
-            if (latRef[0] == 'S')
-                *latitude *= -1.0;
+                if (!ref.empty())
+                    record.speedRef = ref[0];
+            }
+            else if (strcmp(tag, "Track") == 0)
+            {
+                if (decodeXmpRational(*it, value))
+                {
+                    record.track    = value;
+                    record.hasTrack = true;
+                }
+            }
+            else if (strcmp(tag, "TrackRef") == 0)
+            {
+                const std::string ref = it->toString();
 
-            return true;
+                if (!ref.empty())
+                    record.trackRef = ref[0];
+            }
+            else if (strcmp(tag, "ImgDirection") == 0)
+            {
+                if (decodeXmpRational(*it, value))
+                {
+                    record.imgDirection    = value;
+                    record.hasImgDirection = true;
+                }
+            }
+            else if (strcmp(tag, "ImgDirectionRef") == 0)
+            {
+                const std::string ref = it->toString();
+
+                if (!ref.empty())
+                    record.imgDirectionRef = ref[0];
+            }
+            else if (strcmp(tag, "MapDatum") == 0)
+            {
+                const QString datum = QString::fromStdString(it->toString()).trimmed();
+
+                if (!datum.isEmpty())
+                    record.mapDatum = datum;
+            }
         }
+
+        if (xmpAltitudeRef && xmpAltitude && !xmpAltitudeRef->toString().empty() &&
+            decodeXmpRational(*xmpAltitude, value))
+        {
+            record.altitude    = (xmpAltitudeRef->toString() == "1") ? -value : value;
+            record.hasAltitude = true;
+        }
+
+#endif // _XMP_SUPPORT_
+
     }
     catch( Exiv2::Error& e )
     {
@@ -120,89 +444,86 @@ bool KExiv2::getGPSLatitudeNumber(double* const latitude) const
         qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
     }
 
-    return false;
+    return record;
 }
 
-bool KExiv2::getGPSLongitudeNumber(double* const longitude) const
+bool KExiv2::getGPSInfo(double& altitude, double& latitude, double& longitude) const
+{
+    // All values are decoded in a single pass. Some GPS device do not set Altitude.
+    // So a valid GPS position can be with a zero value.
+
+    const GPSRecord record = gpsRecord();
+    altitude               = record.altitude;
+    latitude               = record.latitude;
+    longitude              = record.longitude;
+
+    return (record.hasLatitude && record.hasLongitude);
+}
+
+bool KExiv2::getGPSLatitudeNumber(double* const latitude) const
 {
     try
     {
-        *longitude=0.0;
+        *latitude=0.0;
 
         // Try XMP first. Reason: XMP in sidecar may be more up-to-date than EXIF in original image.
-        if ( convertFromGPSCoordinateString(getXmpTagString("Xmp.exif.GPSLongitude"), longitude) )
+        if ( convertFromGPSCoordinateString(getXmpTagString("Xmp.exif.GPSLatitude"), latitude) )
             return true;
 
         // Now try to get the reference from Exif.
-        const QByteArray lngRef = getExifTagData("Exif.GPSInfo.GPSLongitudeRef");
+        const Exiv2::ExifData& exifData(std::as_const(*d).exifMetadata());
+        Exiv2::ExifData::const_iterator ref = exifData.findKey(Exiv2::ExifKey("Exif.GPSInfo.GPSLatitudeRef"));
 
-        if (!lngRef.isEmpty())
+        if (ref != exifData.end() && exifReference(*ref))
         {
-            // Longitude decoding from Exif.
-
-            Exiv2::ExifKey exifKey2("Exif.GPSInfo.GPSLongitude");
-            Exiv2::ExifData exifData(d->exifMetadata());
-            Exiv2::ExifData::iterator it = exifData.findKey(exifKey2);
-
-            if (it != exifData.end() && (*it).count() == 3)
-            {
-                /// @todo Decoding of latitude and longitude works in the same way,
-                ///       code here can be put in a separate function
-                double num, den;
-
-                num = (double)((*it).toRational(0).first);
-                den = (double)((*it).toRational(0).second);
+            Exiv2::ExifData::const_iterator it = exifData.findKey(Exiv2::ExifKey("Exif.GPSInfo.GPSLatitude"));
 
-                if (den == 0)
-                {
-                    return false;
-                }
-
-                *longitude = num/den;
+            // Latitude decoding from Exif.
+            if (it == exifData.end() || !decodeExifCoordinate(*it, *latitude))
+                return false;
 
-                num = (double)((*it).toRational(1).first);
-                den = (double)((*it).toRational(1).second);
+            if (exifReference(*ref) == 'S')
+                *latitude *= -1.0;
 
-                if (den == 0)
-                {
-                    return false;
-                }
+            return true;
+        }
+    }
+    catch( Exiv2::Error& e )
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot get GPS tag using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
 
-                const double min = num/den;
+    return false;
+}
 
-                if (min != -1.0)
-                {
-                    *longitude = *longitude + min/60.0;
-                }
+bool KExiv2::getGPSLongitudeNumber(double* const longitude) const
+{
+    try
+    {
+        *longitude=0.0;
 
-                num = (double)((*it).toRational(2).first);
-                den = (double)((*it).toRational(2).second);
+        // Try XMP first. Reason: XMP in sidecar may be more up-to-date than EXIF in original image.
+        if ( convertFromGPSCoordinateString(getXmpTagString("Xmp.exif.GPSLongitude"), longitude) )
+            return true;
 
-                if (den == 0)
-                {
-                    // be relaxed and accept 0/0 seconds. See #246077.
-                    if (num == 0)
-                        den = 1;
-                    else
-                        return false;
-                }
+        // Now try to get the reference from Exif.
+        const Exiv2::ExifData& exifData(std::as_const(*d).exifMetadata());
+        Exiv2::ExifData::const_iterator ref = exifData.findKey(Exiv2::ExifKey("Exif.GPSInfo.GPSLongitudeRef"));
 
-                const double sec = num/den;
+        if (ref != exifData.end() && exifReference(*ref))
+        {
+            Exiv2::ExifData::const_iterator it = exifData.findKey(Exiv2::ExifKey("Exif.GPSInfo.GPSLongitude"));
 
-                if (sec != -1.0)
-                {
-                    *longitude = *longitude + sec/3600.0;
-                }
-            }
-            else
-            {
+            // Longitude decoding from Exif.
+            if (it == exifData.end() || !decodeExifCoordinate(*it, *longitude))
                 return false;
-            }
 
-            if (lngRef[0] == 'W')
-            {
+            if (exifReference(*ref) == 'W')
                 *longitude *= -1.0;
-            }
 
             return true;
         }
@@ -251,31 +572,19 @@ bool KExiv2::getGPSAltitude(double* const altitude) const
         }
 
         // Get the reference from Exif (above/below sea level)
-        const QByteArray altRef = getExifTagData("Exif.GPSInfo.GPSAltitudeRef");
+        const Exiv2::ExifData& exifData(std::as_const(*d).exifMetadata());
+        Exiv2::ExifData::const_iterator ref = exifData.findKey(Exiv2::ExifKey("Exif.GPSInfo.GPSAltitudeRef"));
 
-        if (!altRef.isEmpty())
+        if (ref != exifData.end() && ref->count())
         {
             // Altitude decoding from Exif.
 
-            Exiv2::ExifKey exifKey3("Exif.GPSInfo.GPSAltitude");
-            Exiv2::ExifData exifData(d->exifMetadata());
-            Exiv2::ExifData::iterator it = exifData.findKey(exifKey3);
-            if (it != exifData.end() && (*it).count())
-            {
-                num = (double)((*it).toRational(0).first);
-                den = (double)((*it).toRational(0).second);
-
-                if (den == 0)
-                    return false;
+            Exiv2::ExifData::const_iterator it = exifData.findKey(Exiv2::ExifKey("Exif.GPSInfo.GPSAltitude"));
 
-                *altitude = num/den;
-            }
-            else
-            {
+            if (it == exifData.end() || !decodeExifRational(*it, *altitude))
                 return false;
-            }
 
-            if (altRef[0] == '1')
+            if (isBelowSeaLevel(*ref))
                 *altitude *= -1.0;
 
             return true;
@@ -315,7 +624,7 @@ QString KExiv2::getGPSLongitudeString() const
 
 bool KExiv2::initializeGPSInfo(const bool setProgramName)
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -362,7 +671,18 @@ bool KExiv2::setGPSInfo(const double altitude, const double latitude, const doub
 
 bool KExiv2::setGPSInfo(const double* const altitude, const double latitude, const double longitude, const bool setProgramName)
 {
-    if (!setProgramId(setProgramName))
+    long int nom = 0, denom = 1;
+
+    if (altitude)
+        convertToRational(fabs(*altitude), &nom, &denom, 4);
+
+    return setGPSInfo(altitude, nom, denom, latitude, longitude, setProgramName);
+}
+
+bool KExiv2::setGPSInfo(const double* const altitude, long int altitudeNumerator, long int altitudeDenominator,
+                        const double latitude, const double longitude, const bool setProgramName)
+{
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -375,7 +695,6 @@ bool KExiv2::setGPSInfo(const double* const altitude, const double latitude, con
             return false;
 
         char scratchBuf[100];
-        long int nom, denom;
         long int deg, min;
 
         // Now start adding data.
@@ -396,8 +715,7 @@ bool KExiv2::setGPSInfo(const double* const altitude, const double latitude, con
             d->exifMetadata().add(Exiv2::ExifKey("Exif.GPSInfo.GPSAltitudeRef"), value.get());
 
             // And the actual altitude, as absolute value..
-            convertToRational(fabs(*altitude), &nom, &denom, 4);
-            snprintf(scratchBuf, 100, "%ld/%ld", nom, denom);
+            snprintf(scratchBuf, 100, "%ld/%ld", altitudeNumerator, altitudeDenominator);
             d->exifMetadata()["Exif.GPSInfo.GPSAltitude"] = scratchBuf;
 
 #ifdef _XMP_SUPPORT_
@@ -506,7 +824,7 @@ bool KExiv2::setGPSInfo(const double altitude, const QString& latitude, const QS
 
 bool KExiv2::removeGPSInfo(const bool setProgramName)
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -640,6 +958,54 @@ void KExiv2::convertToRational(const double number, long int* const numerator,
     *denominator = (int)denTemp;
 }
 
+void KExiv2::convertToRationals(const double* const numbers, long int* const numerators,
+                                long int* const denominators, const int count, const int rounding)
+{
+    // Same results as convertToRational(), with integer arithmetic: the power of ten is computed
+    // once, and the reduction by 2 is a count of trailing zero bits instead of a loop of divisions.
+    // The denominator is 10^rounding, so it has exactly rounding factors 2.
+    // Values which do not fit in an int, as convertToRational() returns them, use convertToRational().
+
+    if (rounding < 0 || rounding > 9)
+    {
+        for (int i = 0 ; i < count ; ++i)
+            convertToRational(numbers[i], &numerators[i], &denominators[i], rounding);
+
+        return;
+    }
+
+    const double  rounder     = pow(10.0, rounding);
+    const qint64  denominator = (qint64)rounder;
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        const double whole      = trunc(numbers[i]);
+        const double fractional = round((numbers[i] - whole) * rounder);
+        const double numTemp    = (whole * rounder) + fractional;
+
+        if (!(fabs(numTemp) <= (double)INT_MAX))
+        {
+            convertToRational(numbers[i], &numerators[i], &denominators[i], rounding);
+            continue;
+        }
+
+        const qint64 num = (qint64)numTemp;
+
+        if ((num % denominator) == 0)
+        {
+            // Simple reduction.
+            numerators[i]   = (long int)(num / denominator);
+            denominators[i] = 1;
+        }
+        else
+        {
+            const int shift = qMin((int)qCountTrailingZeroBits((quint64)(num < 0 ? -num : num)), rounding);
+            numerators[i]   = (long int)(num >> shift);
+            denominators[i] = (long int)(denominator >> shift);
+        }
+    }
+}
+
 void KExiv2::convertToRationalSmallDenominator(const double number, long int* const numerator, long int* const denominator)
 {
     // This function converts the given decimal number
@@ -780,45 +1146,288 @@ QString KExiv2::convertToGPSCoordinateString(const long int numeratorDegrees, co
     return coordinate;
 }
 
-QString KExiv2::convertToGPSCoordinateString(const bool isLatitude, double coordinate)
+/** Powers of ten exactly representable as double.
+ */
+static const double s_powersOf10[] =
 {
-    if (coordinate < -360.0 || coordinate > 360.0)
-        return QString();
+    1e0, 1e1, 1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
 
-    QString coordinateString;
+/** Writes the decimal digits of \a value at \a buffer, and returns the number of digits written.
+ */
+static int writeDigits(quint64 value, char* const buffer)
+{
+    char digits[20];
+    int  count = 0;
 
-    char directionReference;
+    do
+    {
+        digits[count++] = (char)('0' + (value % 10));
+        value          /= 10;
+    }
+    while (value);
 
-    if (isLatitude)
+    for (int i = 0 ; i < count ; ++i)
     {
-        if (coordinate < 0)
-            directionReference = 'S';
+        buffer[i] = digits[count - 1 - i];
+    }
+
+    return count;
+}
+
+/** Returns \a value * 10^8 rounded to the nearest integer, as QString::number(value, 'f', 8) does
+ *  with the exact binary value of \a value. The error of the product is computed with a fused
+ *  multiply-add, so that it is taken into account when the product is close to a half integer.
+ *  Exact half integers cannot happen, as 10^-8 has no finite binary representation.
+ */
+static quint64 roundedFixedPoint8(const double value)
+{
+    const double product  = value * 1e8;
+    const double error    = std::fma(value, 1e8, -product);
+    const double integer  = floor(product);
+    const double fraction = product - integer;
+    quint64 result        = (quint64)integer;
+
+    if (fraction > 0.5 || (fraction == 0.5 && error > 0.0))
+    {
+        ++result;
+    }
+
+    return result;
+}
+
+/** Returns the code of a Latin-1 or UTF-16 character.
+ */
+static inline unsigned int gpsCharCode(const char c)
+{
+    return (unsigned char)c;
+}
+
+static inline unsigned int gpsCharCode(const QChar c)
+{
+    return c.unicode();
+}
+
+/** Fast parser for the GPSCoordinate strings "DDD,MM.mmk" and "DDD,MM,SSk" made of plain digits
+ *  and an ASCII direction reference, as written by convertToGPSCoordinateString().
+ *  Returns false for all other strings, which are left to the QString based implementation,
+ *  to keep its exact behavior.
+ *
+ *  The minutes are converted with one division of two exactly representable doubles, so the
+ *  result is correctly rounded, as with QString::toDouble().
+ */
+template <typename Char>
+static bool parseGPSCoordinate(const Char* const buffer, const int size, double* const degrees)
+{
+    // At least "D,Mk".
+
+    if (size < 4)
+    {
+        return false;
+    }
+
+    const int          end       = size - 1;
+    const unsigned int reference = gpsCharCode(buffer[end]);
+
+    if (reference >= 0x80)
+    {
+        return false;
+    }
+
+    long   values[3] = { 0, 0, 0 };
+    double minutes   = 0.0;
+    bool   decimal   = false;
+    int    count     = 0;
+    int    pos       = 0;
+
+    while (true)
+    {
+        // Integer part. 9 digits at most, so that the value fits in a 32 bits long.
+
+        const int start   = pos;
+        quint64  mantissa = 0;
+
+        while ((pos < end) && (pos - start < 9))
+        {
+            const unsigned int digit = gpsCharCode(buffer[pos]) - '0';
+
+            if (digit > 9)
+            {
+                break;
+            }
+
+            mantissa = mantissa * 10 + digit;
+            ++pos;
+        }
+
+        if (pos == start)
+        {
+            return false;
+        }
+
+        if ((pos < end) && (gpsCharCode(buffer[pos]) == '.'))
+        {
+            // Decimal minutes, only in the second and last part. 15 significant digits at most,
+            // so that the mantissa is exactly representable as a double.
+
+            if (count != 1)
+            {
+                return false;
+            }
+
+            const int fractionStart = ++pos;
+            const int maxDigits     = 15 - (fractionStart - 1 - start);
+
+            while ((pos < end) && (pos - fractionStart < maxDigits))
+            {
+                const unsigned int digit = gpsCharCode(buffer[pos]) - '0';
+
+                if (digit > 9)
+                {
+                    break;
+                }
+
+                mantissa = mantissa * 10 + digit;
+                ++pos;
+            }
+
+            if (pos == fractionStart)
+            {
+                return false;
+            }
+
+            minutes = (double)mantissa / s_powersOf10[pos - fractionStart];
+            decimal = true;
+        }
         else
-            directionReference = 'N';
+        {
+            values[count] = (long)mantissa;
+        }
+
+        ++count;
+
+        if (pos == end)
+        {
+            break;
+        }
+
+        if ((gpsCharCode(buffer[pos]) != ',') || (count == 3) || decimal)
+        {
+            return false;
+        }
+
+        ++pos;
+    }
+
+    // Same operations as convertFromGPSCoordinateString(), for bit identical results.
+
+    if (count == 2)
+    {
+        // form DDD,MM.mmk
+        *degrees =  values[0];
+        *degrees += (decimal ? minutes : (double)values[1]) / 60.0;
+    }
+    else if (count == 3)
+    {
+        // use form DDD,MM,SSk
+        *degrees =  values[0];
+        *degrees += values[1] / 60.0;
+        *degrees += values[2] / 3600.0;
     }
     else
     {
-        if (coordinate < 0)
-            directionReference = 'W';
-        else
-            directionReference = 'E';
+        return false;
     }
 
+    if (reference == 'W' || reference == 'S' || reference == 'w' || reference == 's')
+    {
+        *degrees *= -1.0;
+    }
+
+    return true;
+}
+
+int KExiv2::convertToGPSCoordinateString(const bool isLatitude, double coordinate,
+                                         char* const buffer, const int size)
+{
+    if (!(coordinate >= -360.0 && coordinate <= 360.0))
+        return 0;
+
+    char directionReference;
+
+    if (isLatitude)
+        directionReference = (coordinate < 0) ? 'S' : 'N';
+    else
+        directionReference = (coordinate < 0) ? 'W' : 'E';
+
     // remove sign
-    coordinate     = fabs(coordinate);
+    coordinate                  = fabs(coordinate);
+    const int degrees           = (int)floor(coordinate);
+    // To minutes, with 8 decimals.
+    const quint64 minutes       = roundedFixedPoint8((coordinate - (double)(degrees)) * 60.0);
+    const quint64 wholeMinutes  = minutes / 100000000;
+    quint64       fraction      = minutes % 100000000;
 
-    int degrees    = (int)floor(coordinate);
-    // get fractional part
-    coordinate     = coordinate - (double)(degrees);
-    // To minutes
-    double minutes = coordinate * 60.0;
+    // Worst case: "360,60.00000000N" and the null char.
+
+    char  scratch[32];
+    char* out = scratch;
 
     // use form DDD,MM.mmk
-    coordinateString = QString::fromLatin1("%1,%2%3");
-    coordinateString = coordinateString.arg(degrees);
-    coordinateString = coordinateString.arg(minutes, 0, 'f', 8).arg(directionReference);
+    out   += writeDigits((quint64)degrees, out);
+    *out++ = ',';
+    out   += writeDigits(wholeMinutes, out);
+    *out++ = '.';
+
+    for (int i = 7 ; i >= 0 ; --i)
+    {
+        out[i]    = (char)('0' + (fraction % 10));
+        fraction /= 10;
+    }
+
+    out   += 8;
+    *out++ = directionReference;
+
+    const int length = (int)(out - scratch);
+
+    if (!buffer || length >= size)
+        return 0;
+
+    memcpy(buffer, scratch, length);
+    buffer[length] = '\0';
+
+    return length;
+}
+
+QStringList KExiv2::convertToGPSCoordinateStrings(const bool isLatitude, const QList<double>& coordinates)
+{
+    QStringList strings;
+    strings.reserve(coordinates.size());
+    char buffer[32];
+
+    for (const double coordinate : coordinates)
+    {
+        const int length = convertToGPSCoordinateString(isLatitude, coordinate, buffer, sizeof(buffer));
+
+        if (length)
+            strings.append(QString::fromLatin1(buffer, length));
+        else
+            strings.append(QString());
+    }
 
-    return coordinateString;
+    return strings;
+}
+
+QString KExiv2::convertToGPSCoordinateString(const bool isLatitude, double coordinate)
+{
+    char buffer[32];
+    const int length = convertToGPSCoordinateString(isLatitude, coordinate, buffer, sizeof(buffer));
+
+    if (!length)
+        return QString();
+
+    return QString::fromLatin1(buffer, length);
 }
 
 bool KExiv2::convertFromGPSCoordinateString(const QString& gpsString,
@@ -875,6 +1484,9 @@ bool KExiv2::convertFromGPSCoordinateString(const QString& gpsString, double* co
     if (gpsString.isEmpty())
         return false;
 
+    if (parseGPSCoordinate(gpsString.constData(), gpsString.size(), degrees))
+        return true;
+
     char directionReference = gpsString.at(gpsString.length() - 1).toUpper().toLatin1();
     QString coordinate      = gpsString.left(gpsString.length() - 1);
     QStringList parts       = coordinate.split(QString::fromLatin1(","));
@@ -909,6 +1521,35 @@ bool KExiv2::convertFromGPSCoordinateString(const QString& gpsString, double* co
     }
 }
 
+bool KExiv2::convertFromGPSCoordinateString(const char* const gpsString, const int size, double* const coordinate)
+{
+    if (!gpsString || size <= 0)
+        return false;
+
+    if (parseGPSCoordinate(gpsString, size, coordinate))
+        return true;
+
+    return convertFromGPSCoordinateString(QString::fromLatin1(gpsString, size), coordinate);
+}
+
+QList<double> KExiv2::convertFromGPSCoordinateStrings(const QStringList& gpsStrings)
+{
+    QList<double> coordinates;
+    coordinates.reserve(gpsStrings.size());
+
+    for (const QString& gpsString : gpsStrings)
+    {
+        double coordinate = 0.0;
+
+        if (convertFromGPSCoordinateString(gpsString, &coordinate))
+            coordinates.append(coordinate);
+        else
+            coordinates.append(std::numeric_limits<double>::quiet_NaN());
+    }
+
+    return coordinates;
+}
+
 bool KExiv2::convertToUserPresentableNumbers(const QString& gpsString,
                                              int* const degrees, int* const minutes,
                                              double* const seconds, char* const directionReference)
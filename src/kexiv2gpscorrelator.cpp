@@ -0,0 +1,724 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kexiv2gpscorrelator.h"
+
+// C++ includes
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+// Qt includes
+
+#include <QByteArrayView>
+#include <QFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimeZone>
+#include <QVector>
+#include <QXmlStreamReader>
+
+// Local includes
+
+#include "libkexiv2_debug.h"
+
+namespace KExiv2Iface
+{
+
+/** The number of files geotagged by a thread at once.
+ */
+static const int s_geotagChunkSize = 32;
+
+class KExiv2GPSCorrelatorPrivate
+{
+public:
+
+    /** A point of the track. Altitude is NaN if not available.
+     */
+    struct TrackPoint
+    {
+        qint64 msecs;
+        double latitude;
+        double longitude;
+        double altitude;
+    };
+
+public:
+
+    KExiv2GPSCorrelatorPrivate()
+      : maximumGap(30),
+        interpolationGap(600),
+        cameraTimeOffset(0)
+    {
+    }
+
+    /** Sorts the points appended since the last call by time, and merges the points with the same time.
+     */
+    void sortTrack();
+
+    /** Parses one NMEA sentence, and appends the fix to the track. Returns true if a fix was found.
+     */
+    bool parseNMEASentence(QByteArrayView sentence);
+
+    KExiv2GPSCorrelator::Match correlate(qint64 msecs) const;
+
+public:
+
+    QVector<TrackPoint> track;
+
+    int                 maximumGap;
+    int                 interpolationGap;
+    qint64              cameraTimeOffset;
+
+    // NMEA parser state: the date of the last $GPRMC sentence and its time of the day.
+
+    QDate               nmeaDate;
+    int                 nmeaTime = -1;
+};
+
+void KExiv2GPSCorrelatorPrivate::sortTrack()
+{
+    const auto byTime = [](const TrackPoint& a, const TrackPoint& b)
+    {
+        return a.msecs < b.msecs;
+    };
+
+    // Tracks are nearly always recorded in chronological order.
+
+    if (!std::is_sorted(track.constBegin(), track.constEnd(), byTime))
+    {
+        std::stable_sort(track.begin(), track.end(), byTime);
+    }
+
+    // Merge the points with the same time, as the $GPRMC and $GPGGA sentences of a NMEA fix.
+
+    if (track.size() < 2)
+    {
+        return;
+    }
+
+    int last = 0;
+
+    for (int i = 1 ; i < track.size() ; ++i)
+    {
+        if (track.at(i).msecs == track.at(last).msecs)
+        {
+            if (std::isnan(track.at(last).altitude))
+            {
+                track[last].altitude = track.at(i).altitude;
+            }
+        }
+        else
+        {
+            track[++last] = track.at(i);
+        }
+    }
+
+    track.resize(last + 1);
+}
+
+KExiv2GPSCorrelator::Match KExiv2GPSCorrelatorPrivate::correlate(qint64 msecs) const
+{
+    KExiv2GPSCorrelator::Match match;
+
+    if (track.isEmpty())
+    {
+        return match;
+    }
+
+    msecs += cameraTimeOffset * 1000;
+
+    // First track point after the date.
+
+    QVector<TrackPoint>::const_iterator next = std::upper_bound(track.constBegin(), track.constEnd(), msecs,
+                                                                [](qint64 value, const TrackPoint& point)
+                                                                {
+                                                                    return value < point.msecs;
+                                                                });
+
+    const TrackPoint* const after  = (next != track.constEnd())   ? &(*next)       : nullptr;
+    const TrackPoint* const before = (next != track.constBegin()) ? &(*(next - 1)) : nullptr;
+
+    const qint64 gapBefore         = before ? (msecs - before->msecs) : -1;
+    const qint64 gapAfter          = after  ? (after->msecs  - msecs) : -1;
+
+    // Exact match, or interpolation between the surrounding points.
+
+    if (before && (gapBefore == 0 || (after && interpolationGap > 0 &&
+                                      (after->msecs - before->msecs) <= (qint64)interpolationGap * 1000)))
+    {
+        if (gapBefore == 0)
+        {
+            match.latitude    = before->latitude;
+            match.longitude   = before->longitude;
+            match.altitude    = before->altitude;
+        }
+        else
+        {
+            const double ratio    = (double)gapBefore / (double)(after->msecs - before->msecs);
+            double deltaLongitude = after->longitude - before->longitude;
+
+            // Shortest way across the antimeridian.
+
+            if (deltaLongitude > 180.0)
+                deltaLongitude -= 360.0;
+            else if (deltaLongitude < -180.0)
+                deltaLongitude += 360.0;
+
+            match.latitude       = before->latitude + (after->latitude - before->latitude) * ratio;
+            match.longitude      = before->longitude + deltaLongitude * ratio;
+            match.altitude       = before->altitude + (after->altitude - before->altitude) * ratio;
+            match.isInterpolated = true;
+
+            if (match.longitude > 180.0)
+                match.longitude -= 360.0;
+            else if (match.longitude < -180.0)
+                match.longitude += 360.0;
+        }
+
+        match.isValid     = true;
+        match.hasAltitude = !std::isnan(match.altitude);
+        match.gap         = (after ? qMin(gapBefore, gapAfter) : gapBefore) / 1000.0;
+
+        if (!match.hasAltitude)
+            match.altitude = 0.0;
+
+        return match;
+    }
+
+    // Nearest point.
+
+    const TrackPoint* nearest = nullptr;
+    qint64 gap                = 0;
+
+    if (before && (!after || gapBefore <= gapAfter))
+    {
+        nearest = before;
+        gap     = gapBefore;
+    }
+    else
+    {
+        nearest = after;
+        gap     = gapAfter;
+    }
+
+    if (gap > (qint64)maximumGap * 1000)
+    {
+        return match;
+    }
+
+    match.isValid     = true;
+    match.latitude    = nearest->latitude;
+    match.longitude   = nearest->longitude;
+    match.hasAltitude = !std::isnan(nearest->altitude);
+    match.altitude    = match.hasAltitude ? nearest->altitude : 0.0;
+    match.gap         = gap / 1000.0;
+
+    return match;
+}
+
+/** Parses "hhmmss" or "hhmmss.sss", and returns the milliseconds since the start of the day or -1.
+ */
+static int parseNMEATime(QByteArrayView field)
+{
+    if (field.size() < 6)
+        return -1;
+
+    for (int i = 0 ; i < 6 ; ++i)
+    {
+        if (field.at(i) < '0' || field.at(i) > '9')
+            return -1;
+    }
+
+    const int hours   = (field.at(0) - '0') * 10 + (field.at(1) - '0');
+    const int minutes = (field.at(2) - '0') * 10 + (field.at(3) - '0');
+    bool ok           = true;
+    const double secs = field.sliced(4).toDouble(&ok);
+
+    if (!ok || hours > 23 || minutes > 59 || secs >= 61.0)
+        return -1;
+
+    return (hours * 60 + minutes) * 60000 + (int)qRound(secs * 1000.0);
+}
+
+/** Parses a NMEA coordinate "dddmm.mmmm" and its hemisphere.
+ */
+static bool parseNMEACoordinate(QByteArrayView field, QByteArrayView hemisphere, double& coordinate)
+{
+    if (field.isEmpty() || hemisphere.isEmpty())
+        return false;
+
+    bool ok            = true;
+    const double value = field.toDouble(&ok);
+
+    if (!ok)
+        return false;
+
+    const double degrees = std::floor(value / 100.0);
+    coordinate           = degrees + (value - degrees * 100.0) / 60.0;
+
+    if (hemisphere.at(0) == 'S' || hemisphere.at(0) == 'W')
+        coordinate = -coordinate;
+
+    return true;
+}
+
+bool KExiv2GPSCorrelatorPrivate::parseNMEASentence(QByteArrayView sentence)
+{
+    if (sentence.size() < 7 || sentence.at(0) != '$')
+        return false;
+
+    // Check the checksum if present.
+
+    const qsizetype star = sentence.indexOf('*');
+
+    if (star != -1)
+    {
+        bool ok              = false;
+        const uint checksum  = sentence.sliced(star + 1).trimmed().toUInt(&ok, 16);
+        uint computed        = 0;
+
+        for (qsizetype i = 1 ; i < star ; ++i)
+            computed ^= (uchar)sentence.at(i);
+
+        if (!ok || checksum != computed)
+            return false;
+
+        sentence = sentence.first(star);
+    }
+
+    // Split the fields, the talker id is ignored.
+
+    QByteArrayView fields[16];
+    int count      = 0;
+    qsizetype from = 0;
+
+    while (count < 16)
+    {
+        const qsizetype comma = sentence.indexOf(',', from);
+
+        if (comma == -1)
+        {
+            fields[count++] = sentence.sliced(from);
+            break;
+        }
+
+        fields[count++] = sentence.sliced(from, comma - from);
+        from            = comma + 1;
+    }
+
+    if (fields[0].size() != 6)
+        return false;
+
+    const QByteArrayView type = fields[0].sliced(3);
+    TrackPoint point;
+    point.altitude            = qQNaN();
+
+    if (type == "RMC")
+    {
+        // $GPRMC,hhmmss.ss,A,llll.ll,a,yyyyy.yy,a,speed,course,ddmmyy,...
+
+        if (count < 10 || fields[2] != "A")
+            return false;
+
+        const int time = parseNMEATime(fields[1]);
+
+        if (time == -1 || fields[9].size() != 6)
+            return false;
+
+        bool ok              = true;
+        const int dateDigits = fields[9].toInt(&ok);
+
+        if (!ok)
+            return false;
+
+        int year = dateDigits % 100;
+        year    += (year >= 80) ? 1900 : 2000;
+        nmeaDate = QDate(year, (dateDigits / 100) % 100, dateDigits / 10000);
+        nmeaTime = time;
+
+        if (!nmeaDate.isValid()                                               ||
+            !parseNMEACoordinate(fields[3], fields[4], point.latitude)        ||
+            !parseNMEACoordinate(fields[5], fields[6], point.longitude))
+        {
+            return false;
+        }
+
+        point.msecs = QDateTime(nmeaDate, QTime(0, 0), QTimeZone(QTimeZone::UTC)).toMSecsSinceEpoch() + time;
+    }
+    else if (type == "GGA")
+    {
+        // $GPGGA,hhmmss.ss,llll.ll,a,yyyyy.yy,a,quality,satellites,hdop,altitude,M,...
+        // The sentence has no date, the one of the previous $GPRMC sentence is used.
+
+        if (count < 10 || !nmeaDate.isValid() || fields[6].isEmpty() || fields[6] == "0")
+            return false;
+
+        const int time = parseNMEATime(fields[1]);
+
+        if (time == -1                                                        ||
+            !parseNMEACoordinate(fields[2], fields[3], point.latitude)        ||
+            !parseNMEACoordinate(fields[4], fields[5], point.longitude))
+        {
+            return false;
+        }
+
+        bool ok               = true;
+        const double altitude = fields[9].toDouble(&ok);
+
+        if (ok && !fields[9].isEmpty())
+            point.altitude = altitude;
+
+        // Past midnight since the last date.
+
+        QDate date = nmeaDate;
+
+        if (time < nmeaTime - 12 * 3600 * 1000)
+            date = date.addDays(1);
+
+        point.msecs = QDateTime(date, QTime(0, 0), QTimeZone(QTimeZone::UTC)).toMSecsSinceEpoch() + time;
+    }
+    else
+    {
+        return false;
+    }
+
+    track.append(point);
+
+    return true;
+}
+
+// -------------------------------------------------------------------------------------------
+
+KExiv2GPSCorrelator::KExiv2GPSCorrelator()
+    : d(new KExiv2GPSCorrelatorPrivate)
+{
+}
+
+KExiv2GPSCorrelator::~KExiv2GPSCorrelator() = default;
+
+bool KExiv2GPSCorrelator::loadGPXFile(const QString& filePath)
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCDebug(LIBKEXIV2_LOG) << "Cannot open GPX file" << filePath;
+        return false;
+    }
+
+    return loadGPXData(file.readAll());
+}
+
+bool KExiv2GPSCorrelator::loadGPXData(const QByteArray& data)
+{
+    QXmlStreamReader reader(data);
+    const int previousSize = d->track.size();
+
+    // Track points, route points and waypoints share the same structure.
+
+    bool inPoint    = false;
+    bool hasTime    = false;
+    KExiv2GPSCorrelatorPrivate::TrackPoint point;
+
+    while (!reader.atEnd())
+    {
+        const QXmlStreamReader::TokenType token = reader.readNext();
+
+        if (token == QXmlStreamReader::StartElement)
+        {
+            const QStringView name = reader.name();
+
+            if (name == QLatin1String("trkpt") || name == QLatin1String("rtept") || name == QLatin1String("wpt"))
+            {
+                bool latitudeOk  = false;
+                bool longitudeOk = false;
+                point.latitude   = reader.attributes().value(QLatin1String("lat")).toDouble(&latitudeOk);
+                point.longitude  = reader.attributes().value(QLatin1String("lon")).toDouble(&longitudeOk);
+                point.altitude   = qQNaN();
+                point.msecs      = 0;
+                inPoint          = latitudeOk && longitudeOk;
+                hasTime          = false;
+            }
+            else if (inPoint && name == QLatin1String("ele"))
+            {
+                bool ok               = false;
+                const double altitude = reader.readElementText().toDouble(&ok);
+
+                if (ok)
+                    point.altitude = altitude;
+            }
+            else if (inPoint && name == QLatin1String("time"))
+            {
+                QDateTime dateTime = KExiv2::convertFromDateTimeString(reader.readElementText().trimmed());
+
+                if (dateTime.isValid())
+                {
+                    // GPX times are UTC.
+
+                    if (dateTime.timeSpec() == Qt::LocalTime)
+                        dateTime.setTimeZone(QTimeZone(QTimeZone::UTC));
+
+                    point.msecs = dateTime.toMSecsSinceEpoch();
+                    hasTime     = true;
+                }
+            }
+        }
+        else if (token == QXmlStreamReader::EndElement && inPoint)
+        {
+            const QStringView name = reader.name();
+
+            if (name == QLatin1String("trkpt") || name == QLatin1String("rtept") || name == QLatin1String("wpt"))
+            {
+                if (hasTime)
+                    d->track.append(point);
+
+                inPoint = false;
+            }
+        }
+    }
+
+    if (reader.hasError())
+    {
+        qCDebug(LIBKEXIV2_LOG) << "Cannot parse GPX data:" << reader.errorString();
+        d->track.resize(previousSize);
+
+        return false;
+    }
+
+    d->sortTrack();
+
+    qCDebug(LIBKEXIV2_LOG) << "GPX track loaded with" << d->track.size() - previousSize << "points";
+
+    return true;
+}
+
+bool KExiv2GPSCorrelator::loadNMEAFile(const QString& filePath)
+{
+    QFile file(filePath);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCDebug(LIBKEXIV2_LOG) << "Cannot open NMEA file" << filePath;
+        return false;
+    }
+
+    return loadNMEAData(file.readAll());
+}
+
+bool KExiv2GPSCorrelator::loadNMEAData(const QByteArray& data)
+{
+    const QByteArrayView view(data);
+    int fixes      = 0;
+    qsizetype from = 0;
+
+    d->nmeaDate    = QDate();
+    d->nmeaTime    = -1;
+
+    while (from < view.size())
+    {
+        qsizetype end = view.indexOf('\n', from);
+
+        if (end == -1)
+            end = view.size();
+
+        if (d->parseNMEASentence(view.sliced(from, end - from).trimmed()))
+            ++fixes;
+
+        from = end + 1;
+    }
+
+    d->sortTrack();
+
+    qCDebug(LIBKEXIV2_LOG) << "NMEA track loaded with" << fixes << "fixes";
+
+    return (fixes > 0);
+}
+
+void KExiv2GPSCorrelator::addTrackPoint(const QDateTime& dateTime, double latitude, double longitude, double altitude)
+{
+    if (!dateTime.isValid())
+        return;
+
+    KExiv2GPSCorrelatorPrivate::TrackPoint point;
+    point.msecs     = dateTime.toMSecsSinceEpoch();
+    point.latitude  = latitude;
+    point.longitude = longitude;
+    point.altitude  = altitude;
+
+    if (d->track.isEmpty() || d->track.constLast().msecs < point.msecs)
+    {
+        d->track.append(point);
+    }
+    else
+    {
+        d->track.append(point);
+        d->sortTrack();
+    }
+}
+
+void KExiv2GPSCorrelator::clear()
+{
+    d->track.clear();
+}
+
+int KExiv2GPSCorrelator::trackPointsCount() const
+{
+    return d->track.size();
+}
+
+QDateTime KExiv2GPSCorrelator::firstDateTime() const
+{
+    if (d->track.isEmpty())
+        return QDateTime();
+
+    return QDateTime::fromMSecsSinceEpoch(d->track.constFirst().msecs, QTimeZone(QTimeZone::UTC));
+}
+
+QDateTime KExiv2GPSCorrelator::lastDateTime() const
+{
+    if (d->track.isEmpty())
+        return QDateTime();
+
+    return QDateTime::fromMSecsSinceEpoch(d->track.constLast().msecs, QTimeZone(QTimeZone::UTC));
+}
+
+void KExiv2GPSCorrelator::setMaximumGap(int seconds)
+{
+    d->maximumGap = qMax(0, seconds);
+}
+
+int KExiv2GPSCorrelator::maximumGap() const
+{
+    return d->maximumGap;
+}
+
+void KExiv2GPSCorrelator::setInterpolationGap(int seconds)
+{
+    d->interpolationGap = qMax(0, seconds);
+}
+
+int KExiv2GPSCorrelator::interpolationGap() const
+{
+    return d->interpolationGap;
+}
+
+void KExiv2GPSCorrelator::setCameraTimeOffset(qint64 seconds)
+{
+    d->cameraTimeOffset = seconds;
+}
+
+qint64 KExiv2GPSCorrelator::cameraTimeOffset() const
+{
+    return d->cameraTimeOffset;
+}
+
+KExiv2GPSCorrelator::Match KExiv2GPSCorrelator::correlate(const QDateTime& dateTime) const
+{
+    if (!dateTime.isValid())
+        return Match();
+
+    return d->correlate(dateTime.toMSecsSinceEpoch());
+}
+
+QList<KExiv2GPSCorrelator::Match> KExiv2GPSCorrelator::correlate(const QList<QDateTime>& dateTimes) const
+{
+    QList<Match> matches;
+    matches.reserve(dateTimes.size());
+
+    for (const QDateTime& dateTime : dateTimes)
+    {
+        matches.append(correlate(dateTime));
+    }
+
+    return matches;
+}
+
+int KExiv2GPSCorrelator::geotagFiles(const QStringList& filePaths, int writingMode,
+                                     int maxThreads, QList<Match>* const matches) const
+{
+    QList<Match> results(filePaths.size());
+    Match* const output = results.data();
+    std::atomic<int> geotagged(0);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount((maxThreads > 0) ? maxThreads : QThread::idealThreadCount());
+
+    // Each thread takes a chunk of files: the altitudes of the positions matched in the chunk
+    // are converted to rationals at once with KExiv2::convertToRationals(), then written.
+
+    for (int first = 0 ; first < filePaths.size() ; first += s_geotagChunkSize)
+    {
+        const int last = qMin(first + s_geotagChunkSize, (int)filePaths.size());
+
+        pool.start([this, &filePaths, writingMode, output, first, last, &geotagged]()
+            {
+                std::vector<KExiv2> images;
+                std::vector<int>    indexes;
+                std::vector<double> altitudes;
+
+                images.reserve(last - first);
+                indexes.reserve(last - first);
+                altitudes.reserve(last - first);
+
+                for (int i = first ; i < last ; ++i)
+                {
+                    KExiv2 meta;
+                    meta.setMetadataWritingMode(writingMode);
+
+                    if (!meta.load(filePaths.at(i)))
+                    {
+                        continue;
+                    }
+
+                    const Match match = correlate(meta.getImageDateTime());
+                    output[i]         = match;
+
+                    if (!match.isValid)
+                    {
+                        qCDebug(LIBKEXIV2_LOG) << "No GPS position found for" << filePaths.at(i);
+                        continue;
+                    }
+
+                    images.push_back(std::move(meta));
+                    indexes.push_back(i);
+                    altitudes.push_back(match.hasAltitude ? fabs(match.altitude) : 0.0);
+                }
+
+                std::vector<long int> numerators(altitudes.size());
+                std::vector<long int> denominators(altitudes.size());
+                KExiv2::convertToRationals(altitudes.data(), numerators.data(), denominators.data(),
+                                           (int)altitudes.size(), 4);
+
+                for (size_t j = 0 ; j < images.size() ; ++j)
+                {
+                    const Match& match = output[indexes[j]];
+
+                    if (images[j].setGPSInfo(match.hasAltitude ? &match.altitude : nullptr,
+                                             numerators[j], denominators[j],
+                                             match.latitude, match.longitude, true) &&
+                        images[j].applyChanges())
+                    {
+                        ++geotagged;
+                    }
+                }
+            });
+    }
+
+    pool.waitForDone();
+
+    if (matches)
+    {
+        *matches = results;
+    }
+
+    return geotagged;
+}
+
+} // namespace KExiv2Iface
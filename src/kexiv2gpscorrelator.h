@@ -0,0 +1,197 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KEXIV2GPSCORRELATOR_H
+#define KEXIV2GPSCORRELATOR_H
+
+// Std
+
+#include <memory>
+
+// Qt includes
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QtNumeric>
+
+// Local includes
+
+#include "libkexiv2_export.h"
+#include "kexiv2.h"
+
+namespace KExiv2Iface
+{
+
+/*!
+ * \class KExiv2Iface::KExiv2GPSCorrelator
+ * \inmodule KExiv2
+ * \inheaderfile KExiv2/KExiv2GPSCorrelator
+ *
+ * \brief Geotagging engine matching images with a GPS track by capture time.
+ *
+ * The GPX or NMEA track is loaded once into an array sorted by time. Each image date is then
+ * located with a binary search, and the position is taken from the nearest track point or
+ * interpolated between the two surrounding points.
+ *
+ * geotagFiles() does the whole job for a list of files: the images are loaded, matched and
+ * saved in parallel.
+ */
+class LIBKEXIV2_EXPORT KExiv2GPSCorrelator
+{
+public:
+
+    /*!
+     * The result of the correlation of a date with the track.
+     */
+    struct Match
+    {
+        /*! \c true if a position was found for the date.
+         */
+        bool   isValid        = false;
+
+        /*! \c true if the position was interpolated between two track points.
+         */
+        bool   isInterpolated = false;
+
+        /*! \c true if the track has an altitude for the position.
+         */
+        bool   hasAltitude    = false;
+
+        double latitude       = 0.0;
+        double longitude      = 0.0;
+        double altitude       = 0.0;
+
+        /*! The time distance in seconds between the date and the nearest track point.
+         */
+        double gap            = 0.0;
+    };
+
+public:
+
+    /*!
+     * Constructs a correlator with an empty track.
+     */
+    KExiv2GPSCorrelator();
+    /*!
+     */
+    ~KExiv2GPSCorrelator();
+
+    /*!
+     * Loads the track points of a GPX file, in addition to the current track.
+     * Returns \c true if the file could be parsed.
+     */
+    bool loadGPXFile(const QString& filePath);
+
+    /*!
+     * Loads the track points of GPX data, in addition to the current track.
+     * Returns \c true if the data could be parsed.
+     */
+    bool loadGPXData(const QByteArray& data);
+
+    /*!
+     * Loads the fixes of a NMEA 0183 log file ($GPRMC and $GPGGA sentences, any talker),
+     * in addition to the current track. Returns \c true if at least one fix was found.
+     */
+    bool loadNMEAFile(const QString& filePath);
+
+    /*!
+     * Loads the fixes of NMEA 0183 data, in addition to the current track.
+     * Returns \c true if at least one fix was found.
+     */
+    bool loadNMEAData(const QByteArray& data);
+
+    /*!
+     * Adds one point to the track. \a altitude can be NaN if not available.
+     * Points are best added in chronological order.
+     */
+    void addTrackPoint(const QDateTime& dateTime, double latitude, double longitude,
+                       double altitude = qQNaN());
+
+    /*!
+     * Removes all points of the track.
+     */
+    void clear();
+
+    /*!
+     * Returns the number of points of the track.
+     */
+    int trackPointsCount() const;
+
+    /*!
+     * Returns the dates of the first and the last track points.
+     */
+    QDateTime firstDateTime() const;
+    /*!
+     */
+    QDateTime lastDateTime() const;
+
+    /*!
+     * Sets the maximum time distance, in \a seconds, between an image and the nearest track point
+     * for the image to be matched. The default is 30 seconds.
+     */
+    void setMaximumGap(int seconds);
+    /*!
+     */
+    int  maximumGap() const;
+
+    /*!
+     * Sets the maximum time distance, in \a seconds, between two track points to interpolate the
+     * position of an image taken between them. 0 disables the interpolation. The default is 600 seconds.
+     */
+    void setInterpolationGap(int seconds);
+    /*!
+     */
+    int  interpolationGap() const;
+
+    /*!
+     * Sets the offset, in \a seconds, added to the image dates before correlation, to correct the
+     * camera clock. Image dates without time zone are in the local time zone of the system.
+     */
+    void   setCameraTimeOffset(qint64 seconds);
+    /*!
+     */
+    qint64 cameraTimeOffset() const;
+
+    /*!
+     * Returns the position of the track at \a dateTime.
+     */
+    Match correlate(const QDateTime& dateTime) const;
+
+    /*!
+     * Batch version of correlate(), for a list of \a dateTimes.
+     */
+    QList<Match> correlate(const QList<QDateTime>& dateTimes) const;
+
+    /*!
+     * Geotags image files: for each file, the date is read with KExiv2::getImageDateTime(),
+     * correlated with the track, and the position written with KExiv2::setGPSInfo().
+     *
+     * Files are processed in parallel by chunks with up to \a maxThreads threads, or
+     * QThread::idealThreadCount() if \a maxThreads is 0. The altitudes of a chunk are
+     * converted at once with KExiv2::convertToRationals(). The metadata are written with the
+     * \a writingMode (see KExiv2::MetadataWritingMode).
+     *
+     * The matches of all files are returned in \a matches if not null. Returns the number of
+     * files geotagged.
+     *
+     * KExiv2::initializeExiv2() must have been called before.
+     */
+    int geotagFiles(const QStringList& filePaths,
+                    int writingMode = KExiv2::WRITETOIMAGEONLY,
+                    int maxThreads = 0,
+                    QList<Match>* const matches = nullptr) const;
+
+private:
+
+    std::unique_ptr<class KExiv2GPSCorrelatorPrivate> const d;
+};
+
+} // namespace KExiv2Iface
+
+#endif // KEXIV2GPSCORRELATOR_H
@@ -0,0 +1,602 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kexiv2gpsindex.h"
+
+// C++ includes
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <vector>
+
+// Qt includes
+
+#include <QVector>
+
+// Local includes
+
+#include "kexiv2.h"
+#include "libkexiv2_debug.h"
+
+namespace KExiv2Iface
+{
+
+/** Deepest level of the quadtree: the longitude and the latitude are quantized on 32 bits.
+ */
+static const int    s_maxLevel    = 32;
+
+/** Cells with less positions are not divided further during the queries.
+ */
+static const int    s_leafSize    = 16;
+
+/** Mean earth radius in meters.
+ */
+static const double s_earthRadius = 6371008.8;
+
+static const double s_degToRad    = 0.017453292519943295;
+
+/** Inserts a 0 bit between all bits of \a value.
+ */
+static quint64 spreadBits(quint32 value)
+{
+    quint64 x = value;
+    x         = (x | (x << 16)) & Q_UINT64_C(0x0000FFFF0000FFFF);
+    x         = (x | (x << 8))  & Q_UINT64_C(0x00FF00FF00FF00FF);
+    x         = (x | (x << 4))  & Q_UINT64_C(0x0F0F0F0F0F0F0F0F);
+    x         = (x | (x << 2))  & Q_UINT64_C(0x3333333333333333);
+    x         = (x | (x << 1))  & Q_UINT64_C(0x5555555555555555);
+
+    return x;
+}
+
+static quint32 quantize(double value, double minimum, double range)
+{
+    const double scaled = (value - minimum) / range * 4294967296.0;
+
+    if (!(scaled > 0.0))
+        return 0;
+
+    if (scaled >= 4294967295.0)
+        return 0xFFFFFFFF;
+
+    return (quint32)scaled;
+}
+
+/** Returns the Morton code of a position: the bits of the quantized longitude and latitude
+ *  interleaved, the longitude on the even bits.
+ */
+static quint64 mortonCode(double latitude, double longitude)
+{
+    return (spreadBits(quantize(longitude, -180.0, 360.0)) |
+            (spreadBits(quantize(latitude,  -90.0, 180.0)) << 1));
+}
+
+/** Great-circle distance in meters, with the haversine formula.
+ */
+static double greatCircleDistance(double latitude1, double longitude1, double latitude2, double longitude2)
+{
+    const double sinLatitude  = sin((latitude2  - latitude1)  * s_degToRad / 2.0);
+    const double sinLongitude = sin((longitude2 - longitude1) * s_degToRad / 2.0);
+    const double a            = sinLatitude * sinLatitude +
+                                cos(latitude1 * s_degToRad) * cos(latitude2 * s_degToRad) * sinLongitude * sinLongitude;
+
+    return 2.0 * s_earthRadius * asin(qMin(1.0, sqrt(a)));
+}
+
+class KExiv2GPSIndexPrivate
+{
+public:
+
+    /** A quadtree cell: the prefix of the Morton codes of its positions at its level, its
+     *  coordinates in the grid of the level, and the range of its positions in the sorted array.
+     */
+    struct Cell
+    {
+        quint64 prefix;
+        int     level;
+        quint32 x;
+        quint32 y;
+        int     begin;
+        int     end;
+
+        double west()  const { return -180.0 + 360.0 * x       / std::ldexp(1.0, level); }
+        double east()  const { return -180.0 + 360.0 * (x + 1) / std::ldexp(1.0, level); }
+        double south() const { return  -90.0 + 180.0 * y       / std::ldexp(1.0, level); }
+        double north() const { return  -90.0 + 180.0 * (y + 1) / std::ldexp(1.0, level); }
+    };
+
+    /** A bounding box in degrees. If west is greater than east, the box crosses the antimeridian.
+     */
+    struct Box
+    {
+        double south;
+        double west;
+        double north;
+        double east;
+
+        bool intersects(const Cell& cell) const
+        {
+            if (cell.south() > north || cell.north() < south)
+                return false;
+
+            if (west <= east)
+                return (cell.west() <= east && cell.east() >= west);
+
+            return (cell.east() >= west || cell.west() <= east);
+        }
+
+        bool contains(const Cell& cell) const
+        {
+            if (cell.south() < south || cell.north() > north)
+                return false;
+
+            if (west <= east)
+                return (cell.west() >= west && cell.east() <= east);
+
+            return (cell.west() >= west || cell.east() <= east);
+        }
+
+        bool contains(double latitude, double longitude) const
+        {
+            if (latitude < south || latitude > north)
+                return false;
+
+            if (west <= east)
+                return (longitude >= west && longitude <= east);
+
+            return (longitude >= west || longitude <= east);
+        }
+    };
+
+public:
+
+    Cell root() const;
+
+    /** Splits a cell in its 4 children. Empty children are skipped. Returns the number of children.
+     */
+    int children(const Cell& cell, Cell* const result) const;
+
+    void collect(const Cell& cell, const Box& box, QList<qint64>& ids) const;
+
+    void collectClusters(const Cell& cell, int level, const Box& box, QList<KExiv2GPSIndex::Cluster>& clusters) const;
+
+    /** Lower bound of the great-circle distance in meters between a position and a cell.
+     */
+    double minimumDistance(double latitude, double longitude, const Cell& cell) const;
+
+public:
+
+    // Sorted by Morton code. The sums of the coordinates are cumulative, with a leading 0,
+    // to compute the mean position of a cluster in constant time.
+
+    QVector<quint64>    codes;
+    QVector<qint64>     ids;
+    QVector<double>     latitudes;
+    QVector<double>     longitudes;
+    QVector<double>     latitudeSums;
+    QVector<double>     longitudeSums;
+
+    bool                dirty = false;
+};
+
+KExiv2GPSIndexPrivate::Cell KExiv2GPSIndexPrivate::root() const
+{
+    Cell cell;
+    cell.prefix = 0;
+    cell.level  = 0;
+    cell.x      = 0;
+    cell.y      = 0;
+    cell.begin  = 0;
+    cell.end    = codes.size();
+
+    return cell;
+}
+
+int KExiv2GPSIndexPrivate::children(const Cell& cell, Cell* const result) const
+{
+    const int shift = 64 - 2 * (cell.level + 1);
+    int count       = 0;
+    int begin       = cell.begin;
+
+    for (quint64 c = 0 ; c < 4 ; ++c)
+    {
+        const quint64 prefix = (cell.prefix << 2) | c;
+        int end              = cell.end;
+
+        if (c < 3)
+        {
+            // First code of the next child.
+
+            const quint64 next = (prefix + 1) << shift;
+            end                = std::lower_bound(codes.constBegin() + begin, codes.constBegin() + cell.end, next) - codes.constBegin();
+        }
+
+        if (end > begin)
+        {
+            Cell& child  = result[count++];
+            child.prefix = prefix;
+            child.level  = cell.level + 1;
+            child.x      = (cell.x << 1) | (quint32)(c & 1);
+            child.y      = (cell.y << 1) | (quint32)(c >> 1);
+            child.begin  = begin;
+            child.end    = end;
+        }
+
+        begin = end;
+    }
+
+    return count;
+}
+
+void KExiv2GPSIndexPrivate::collect(const Cell& cell, const Box& box, QList<qint64>& result) const
+{
+    if (!box.intersects(cell))
+    {
+        return;
+    }
+
+    if (box.contains(cell))
+    {
+        for (int i = cell.begin ; i < cell.end ; ++i)
+        {
+            result.append(ids.at(i));
+        }
+
+        return;
+    }
+
+    if ((cell.end - cell.begin) <= s_leafSize || cell.level == s_maxLevel)
+    {
+        for (int i = cell.begin ; i < cell.end ; ++i)
+        {
+            if (box.contains(latitudes.at(i), longitudes.at(i)))
+            {
+                result.append(ids.at(i));
+            }
+        }
+
+        return;
+    }
+
+    Cell children[4];
+    const int count = this->children(cell, children);
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        collect(children[i], box, result);
+    }
+}
+
+void KExiv2GPSIndexPrivate::collectClusters(const Cell& cell, int level, const Box& box,
+                                            QList<KExiv2GPSIndex::Cluster>& clusters) const
+{
+    if (!box.intersects(cell))
+    {
+        return;
+    }
+
+    if (cell.level == level)
+    {
+        KExiv2GPSIndex::Cluster cluster;
+        cluster.count     = cell.end - cell.begin;
+        cluster.latitude  = (latitudeSums.at(cell.end)  - latitudeSums.at(cell.begin))  / cluster.count;
+        cluster.longitude = (longitudeSums.at(cell.end) - longitudeSums.at(cell.begin)) / cluster.count;
+        cluster.south     = cell.south();
+        cluster.west      = cell.west();
+        cluster.north     = cell.north();
+        cluster.east      = cell.east();
+        clusters.append(cluster);
+
+        return;
+    }
+
+    Cell children[4];
+    const int count = this->children(cell, children);
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        collectClusters(children[i], level, box, clusters);
+    }
+}
+
+double KExiv2GPSIndexPrivate::minimumDistance(double latitude, double longitude, const Cell& cell) const
+{
+    const double south = cell.south();
+    const double north = cell.north();
+    const double west  = cell.west();
+    const double east  = cell.east();
+
+    if (longitude >= west && longitude <= east)
+    {
+        // The nearest point is on the same meridian.
+
+        if (latitude < south)
+            return (south - latitude) * s_degToRad * s_earthRadius;
+
+        if (latitude > north)
+            return (latitude - north) * s_degToRad * s_earthRadius;
+
+        return 0.0;
+    }
+
+    // Else the nearest point is on one of the meridian edges: on a parallel, the distance grows
+    // with the difference of longitude. On a meridian edge, the cosine of the distance is a
+    // sinusoid of the latitude, with its maximum at the foot of the perpendicular from the position.
+
+    const double phi     = latitude * s_degToRad;
+    const double sinPhi  = sin(phi);
+    const double cosPhi  = cos(phi);
+    double       best    = -1.0;
+    const double edges[] = { west, east };
+
+    for (const double edge : edges)
+    {
+        const double delta    = (longitude - edge) * s_degToRad;
+        const double cosDelta = cos(delta);
+        const double bounds[] = { south * s_degToRad, north * s_degToRad };
+
+        for (const double bound : bounds)
+        {
+            best = qMax(best, sinPhi * sin(bound) + cosPhi * cos(bound) * cosDelta);
+        }
+
+        if (cosDelta > 0.0)
+        {
+            const double foot = atan2(sinPhi, cosPhi * cosDelta);
+
+            if (foot > bounds[0] && foot < bounds[1])
+            {
+                best = qMax(best, sinPhi * sin(foot) + cosPhi * cos(foot) * cosDelta);
+            }
+        }
+    }
+
+    // A small margin, for the rounding errors compared to the haversine formula.
+
+    return qMax(0.0, acos(qBound(-1.0, best, 1.0)) * s_earthRadius - 1.0);
+}
+
+// -------------------------------------------------------------------------------------------
+
+KExiv2GPSIndex::KExiv2GPSIndex()
+    : d(new KExiv2GPSIndexPrivate)
+{
+}
+
+KExiv2GPSIndex::~KExiv2GPSIndex() = default;
+
+void KExiv2GPSIndex::add(qint64 id, double latitude, double longitude)
+{
+    if (!(latitude >= -90.0 && latitude <= 90.0 && longitude >= -180.0 && longitude <= 180.0))
+    {
+        qCDebug(LIBKEXIV2_LOG) << "Invalid GPS position ignored:" << latitude << longitude;
+        return;
+    }
+
+    d->codes.append(mortonCode(latitude, longitude));
+    d->ids.append(id);
+    d->latitudes.append(latitude);
+    d->longitudes.append(longitude);
+    d->dirty = true;
+}
+
+bool KExiv2GPSIndex::add(qint64 id, const KExiv2& metadata)
+{
+    const KExiv2::GPSRecord record = metadata.gpsRecord();
+
+    if (!record.isValid())
+    {
+        return false;
+    }
+
+    add(id, record.latitude, record.longitude);
+
+    return true;
+}
+
+void KExiv2GPSIndex::build()
+{
+    if (!d->dirty)
+    {
+        return;
+    }
+
+    const int size = d->codes.size();
+    std::vector<int> order(size);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [this](int a, int b)
+                     {
+                         return d->codes.at(a) < d->codes.at(b);
+                     });
+
+    QVector<quint64> codes(size);
+    QVector<qint64>  ids(size);
+    QVector<double>  latitudes(size);
+    QVector<double>  longitudes(size);
+    d->latitudeSums.resize(size + 1);
+    d->longitudeSums.resize(size + 1);
+    d->latitudeSums[0]  = 0.0;
+    d->longitudeSums[0] = 0.0;
+
+    for (int i = 0 ; i < size ; ++i)
+    {
+        const int from          = order[i];
+        codes[i]                = d->codes.at(from);
+        ids[i]                  = d->ids.at(from);
+        latitudes[i]            = d->latitudes.at(from);
+        longitudes[i]           = d->longitudes.at(from);
+        d->latitudeSums[i + 1]  = d->latitudeSums.at(i)  + latitudes.at(i);
+        d->longitudeSums[i + 1] = d->longitudeSums.at(i) + longitudes.at(i);
+    }
+
+    d->codes.swap(codes);
+    d->ids.swap(ids);
+    d->latitudes.swap(latitudes);
+    d->longitudes.swap(longitudes);
+    d->dirty = false;
+
+    qCDebug(LIBKEXIV2_LOG) << "GPS index built with" << size << "positions";
+}
+
+void KExiv2GPSIndex::clear()
+{
+    d->codes.clear();
+    d->ids.clear();
+    d->latitudes.clear();
+    d->longitudes.clear();
+    d->latitudeSums.clear();
+    d->longitudeSums.clear();
+    d->dirty = false;
+}
+
+int KExiv2GPSIndex::count() const
+{
+    return d->codes.size();
+}
+
+QList<qint64> KExiv2GPSIndex::inBoundingBox(double south, double west, double north, double east) const
+{
+    QList<qint64> result;
+
+    if (d->dirty)
+    {
+        qCDebug(LIBKEXIV2_LOG) << "GPS index used before build()";
+        return result;
+    }
+
+    if (d->codes.isEmpty() || south > north)
+    {
+        return result;
+    }
+
+    d->collect(d->root(), { south, west, north, east }, result);
+
+    return result;
+}
+
+QList<qint64> KExiv2GPSIndex::nearest(double latitude, double longitude, int k, QList<double>* const distances) const
+{
+    QList<qint64> result;
+
+    if (distances)
+    {
+        distances->clear();
+    }
+
+    if (d->dirty)
+    {
+        qCDebug(LIBKEXIV2_LOG) << "GPS index used before build()";
+        return result;
+    }
+
+    if (d->codes.isEmpty() || k <= 0)
+    {
+        return result;
+    }
+
+    // Best-first search: cells and positions are visited by increasing distance. A cell is
+    // queued with a lower bound of the distance to its positions, so a position popped from the
+    // queue is nearer than all positions not popped yet.
+
+    struct Candidate
+    {
+        double                     distance;
+        int                        entry;       // -1 for a cell.
+        KExiv2GPSIndexPrivate::Cell cell;
+
+        bool operator<(const Candidate& other) const
+        {
+            return distance > other.distance;
+        }
+    };
+
+    std::priority_queue<Candidate> queue;
+    Candidate candidate;
+    candidate.distance = 0.0;
+    candidate.entry    = -1;
+    candidate.cell     = d->root();
+    queue.push(candidate);
+
+    while (!queue.empty() && result.size() < k)
+    {
+        const Candidate top = queue.top();
+        queue.pop();
+
+        if (top.entry != -1)
+        {
+            result.append(d->ids.at(top.entry));
+
+            if (distances)
+            {
+                distances->append(top.distance);
+            }
+
+            continue;
+        }
+
+        const KExiv2GPSIndexPrivate::Cell& cell = top.cell;
+
+        if ((cell.end - cell.begin) <= s_leafSize || cell.level == s_maxLevel)
+        {
+            for (int i = cell.begin ; i < cell.end ; ++i)
+            {
+                Candidate entry;
+                entry.distance = greatCircleDistance(latitude, longitude, d->latitudes.at(i), d->longitudes.at(i));
+                entry.entry    = i;
+                entry.cell     = cell;
+                queue.push(entry);
+            }
+
+            continue;
+        }
+
+        KExiv2GPSIndexPrivate::Cell children[4];
+        const int count = d->children(cell, children);
+
+        for (int i = 0 ; i < count ; ++i)
+        {
+            Candidate child;
+            child.distance = d->minimumDistance(latitude, longitude, children[i]);
+            child.entry    = -1;
+            child.cell     = children[i];
+            queue.push(child);
+        }
+    }
+
+    return result;
+}
+
+QList<KExiv2GPSIndex::Cluster> KExiv2GPSIndex::clusters(int level) const
+{
+    return clusters(level, -90.0, -180.0, 90.0, 180.0);
+}
+
+QList<KExiv2GPSIndex::Cluster> KExiv2GPSIndex::clusters(int level, double south, double west, double north, double east) const
+{
+    QList<Cluster> result;
+
+    if (d->dirty)
+    {
+        qCDebug(LIBKEXIV2_LOG) << "GPS index used before build()";
+        return result;
+    }
+
+    if (d->codes.isEmpty() || south > north)
+    {
+        return result;
+    }
+
+    level = qBound(0, level, 24);
+
+    d->collectClusters(d->root(), level, { south, west, north, east }, result);
+
+    return result;
+}
+
+} // namespace KExiv2Iface
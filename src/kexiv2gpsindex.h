@@ -0,0 +1,139 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KEXIV2GPSINDEX_H
+#define KEXIV2GPSINDEX_H
+
+// Std
+
+#include <memory>
+
+// Qt includes
+
+#include <QList>
+#include <QtGlobal>
+
+// Local includes
+
+#include "libkexiv2_export.h"
+
+namespace KExiv2Iface
+{
+
+class KExiv2;
+
+/*!
+ * \class KExiv2Iface::KExiv2GPSIndex
+ * \inmodule KExiv2
+ * \inheaderfile KExiv2/KExiv2GPSIndex
+ *
+ * \brief Spatial index over the GPS positions of a collection of images.
+ *
+ * Each position is stored with an identifier chosen by the caller, as a database id or an
+ * index in a list of files. The positions are sorted by their Morton code (the interleaved
+ * bits of the quantized longitude and latitude), which makes a quadtree of the world where
+ * each cell is a contiguous range of the sorted array.
+ *
+ * Bounding box queries, nearest neighbours and cluster counts at a zoom level walk this
+ * quadtree and only visit the cells matching the query.
+ *
+ * Positions are added with add(), then build() must be called before any query.
+ */
+class LIBKEXIV2_EXPORT KExiv2GPSIndex
+{
+public:
+
+    /*!
+     * A group of positions sharing the same quadtree cell at a zoom level.
+     */
+    struct Cluster
+    {
+        /*! The mean position of the cluster.
+         */
+        double latitude  = 0.0;
+        double longitude = 0.0;
+
+        /*! The bounds of the quadtree cell.
+         */
+        double south     = 0.0;
+        double west      = 0.0;
+        double north     = 0.0;
+        double east      = 0.0;
+
+        /*! The number of positions in the cluster.
+         */
+        int    count     = 0;
+    };
+
+public:
+
+    /*!
+     * Constructs an empty index.
+     */
+    KExiv2GPSIndex();
+    /*!
+     */
+    ~KExiv2GPSIndex();
+
+    /*!
+     * Adds the position of the image \a id. Coordinates are in degrees,
+     * where the sign determines the direction ref (North + / South - ; East + / West -).
+     */
+    void add(qint64 id, double latitude, double longitude);
+
+    /*!
+     * Adds the position of the image \a id, decoded from the \a metadata with KExiv2::gpsRecord().
+     * Returns \c false if the metadata have no GPS position.
+     */
+    bool add(qint64 id, const KExiv2& metadata);
+
+    /*!
+     * Sorts the positions added since the last call. Must be called before the queries.
+     */
+    void build();
+
+    /*!
+     * Removes all positions.
+     */
+    void clear();
+
+    /*!
+     * Returns the number of positions in the index.
+     */
+    int count() const;
+
+    /*!
+     * Returns the identifiers of the images inside the bounding box. If \a west is greater
+     * than \a east, the box crosses the antimeridian.
+     */
+    QList<qint64> inBoundingBox(double south, double west, double north, double east) const;
+
+    /*!
+     * Returns the identifiers of the \a k images nearest to the position, nearest first.
+     * The great-circle distances in meters are returned in \a distances if not null.
+     */
+    QList<qint64> nearest(double latitude, double longitude, int k,
+                          QList<double>* const distances = nullptr) const;
+
+    /*!
+     * Returns the clusters of positions at the zoom \a level, from 0 (one cell for the whole
+     * world) to 24. At each level, cells are divided in 4.
+     */
+    QList<Cluster> clusters(int level) const;
+
+    /*!
+     * Same as clusters(int), limited to the cells intersecting the bounding box.
+     */
+    QList<Cluster> clusters(int level, double south, double west, double north, double east) const;
+
+private:
+
+    std::unique_ptr<class KExiv2GPSIndexPrivate> const d;
+};
+
+} // namespace KExiv2Iface
+
+#endif // KEXIV2GPSINDEX_H
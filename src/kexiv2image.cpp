@@ -11,9 +11,11 @@
 // Qt includes
 
 #include <QBuffer>
+#include <QImageReader>
 
 // Local includes
 
+#include "kexiv2previews.h"
 #include "rotationmatrix.h"
 #include "libkexiv2_debug.h"
 
@@ -34,11 +36,11 @@ bool KExiv2::setImageProgramId(const QString& program, const QString& version) c
 
         // See B.K.O #142564: Check if Exif.Image.Software already exist. If yes, do not touch this tag.
 
-        if (!d->exifMetadata().empty())
+        if (!std::as_const(*d).exifMetadata().empty())
         {
-            Exiv2::ExifData exifData(d->exifMetadata());
+            const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
             Exiv2::ExifKey key("Exif.Image.Software");
-            Exiv2::ExifData::iterator it = exifData.findKey(key);
+            Exiv2::ExifData::const_iterator it = exifData.findKey(key);
 
             if (it == exifData.end())
                 d->exifMetadata()["Exif.Image.Software"] = std::string(software.toLatin1().constData());
@@ -48,12 +50,12 @@ bool KExiv2::setImageProgramId(const QString& program, const QString& version) c
 
 #ifdef _XMP_SUPPORT_
 
-        if (!d->xmpMetadata().empty())
+        if (!std::as_const(*d).xmpMetadata().empty())
         {
             // Only create Xmp.xmp.CreatorTool if it do not exist.
-            Exiv2::XmpData xmpData(d->xmpMetadata());
+            const Exiv2::XmpData& xmpData = std::as_const(*d).xmpMetadata();
             Exiv2::XmpKey key("Xmp.xmp.CreatorTool");
-            Exiv2::XmpData::iterator it = xmpData.findKey(key);
+            Exiv2::XmpData::const_iterator it = xmpData.findKey(key);
 
             if (it == xmpData.end())
                 setXmpTagString("Xmp.xmp.CreatorTool", software, false);
@@ -89,9 +91,9 @@ QSize KExiv2::getImageDimensions() const
 
         // Try to get Exif.Photo tags
 
-        Exiv2::ExifData exifData(d->exifMetadata());
+        const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
         Exiv2::ExifKey key("Exif.Photo.PixelXDimension");
-        Exiv2::ExifData::iterator it = exifData.findKey(key);
+        Exiv2::ExifData::const_iterator it = exifData.findKey(key);
 
         if (it != exifData.end() && it->count())
 #if EXIV2_TEST_VERSION(0,28,0)
@@ -101,7 +103,7 @@ QSize KExiv2::getImageDimensions() const
 #endif
 
         Exiv2::ExifKey key2("Exif.Photo.PixelYDimension");
-        Exiv2::ExifData::iterator it2 = exifData.findKey(key2);
+        Exiv2::ExifData::const_iterator it2 = exifData.findKey(key2);
 
         if (it2 != exifData.end() && it2->count())
 #if EXIV2_TEST_VERSION(0,28,0)
@@ -119,7 +121,7 @@ QSize KExiv2::getImageDimensions() const
         height = -1;
 
         Exiv2::ExifKey key3("Exif.Image.ImageWidth");
-        Exiv2::ExifData::iterator it3 = exifData.findKey(key3);
+        Exiv2::ExifData::const_iterator it3 = exifData.findKey(key3);
 
         if (it3 != exifData.end() && it3->count())
 #if EXIV2_TEST_VERSION(0,28,0)
@@ -129,7 +131,7 @@ QSize KExiv2::getImageDimensions() const
 #endif
 
         Exiv2::ExifKey key4("Exif.Image.ImageLength");
-        Exiv2::ExifData::iterator it4 = exifData.findKey(key4);
+        Exiv2::ExifData::const_iterator it4 = exifData.findKey(key4);
 
         if (it4 != exifData.end() && it4->count())
 #if EXIV2_TEST_VERSION(0,28,0)
@@ -200,7 +202,7 @@ QSize KExiv2::getImageDimensions() const
 
 bool KExiv2::setImageDimensions(const QSize& size, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -242,8 +244,8 @@ KExiv2::ImageOrientation KExiv2::getImageOrientation() const
 {
     try
     {
-        Exiv2::ExifData exifData(d->exifMetadata());
-        Exiv2::ExifData::iterator it;
+        const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
+        Exiv2::ExifData::const_iterator it;
         long orientation;
         ImageOrientation imageOrient = ORIENTATION_NORMAL;
 
@@ -353,7 +355,7 @@ KExiv2::ImageOrientation KExiv2::getImageOrientation() const
 
 bool KExiv2::setImageOrientation(ImageOrientation orientation, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -410,12 +412,11 @@ bool KExiv2::setImageOrientation(ImageOrientation orientation, bool setProgramNa
         if (it != d->exifMetadata().end() && it->count())
         {
 #if EXIV2_TEST_VERSION(0,28,0)
-            RotationMatrix operation((KExiv2Iface::KExiv2::ImageOrientation)it->toUint32());
+            const ImageOrientation thumbOrientation = (ImageOrientation)it->toUint32();
 #else
-            RotationMatrix operation((KExiv2Iface::KExiv2::ImageOrientation)it->toLong());
+            const ImageOrientation thumbOrientation = (ImageOrientation)it->toLong();
 #endif
-            operation *= orientation;
-            (*it) = static_cast<uint16_t>(operation.exifOrientation());
+            (*it) = static_cast<uint16_t>(RotationMatrix::combine(thumbOrientation, orientation));
         }
 
         return true;
@@ -432,6 +433,97 @@ bool KExiv2::setImageOrientation(ImageOrientation orientation, bool setProgramNa
     return false;
 }
 
+RotationMatrix KExiv2::normalizeOrientation(bool setProgramName) const
+{
+    const ImageOrientation orientation = getImageOrientation();
+
+    if (orientation <= ORIENTATION_NORMAL || orientation > ORIENTATION_LAST_VALUE)
+        return RotationMatrix();
+
+    // Keep the metadata as they are, to restore them if one of the steps fails, with
+    // the side effects an enclosing edit may have deferred already.
+    const QSharedDataPointer<KExiv2DataPrivate> backup = d->data;
+    const bool pendingProgramId                        = d->pendingProgramId;
+    const bool pendingIptcCharset                      = d->pendingIptcCharset;
+
+    // All steps are one edit: one undo step, the program id and the IPTC character set set once.
+    beginEdit();
+
+    bool ok = applyProgramId(setProgramName);
+
+    try
+    {
+        // -- Exif thumbnail: without its own orientation tag, it is displayed as the image.
+
+        const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
+
+        if (*Exiv2::ExifThumbC(exifData).extension())
+        {
+            if (exifData.findKey(Exiv2::ExifKey("Exif.Thumbnail.Orientation")) == exifData.end())
+            {
+                d->exifMetadata()["Exif.Thumbnail.Orientation"] = static_cast<uint16_t>(orientation);
+            }
+
+            ok = normalizeExifThumbnailOrientation(false);
+        }
+
+        // -- IPTC preview ---------------------------------------------
+
+        if (ok)
+        {
+            const QByteArray data = getIptcTagData("Iptc.Application2.Preview");
+
+            if (!data.isEmpty())
+            {
+                QImage preview;
+                ok = preview.loadFromData(data) && rotateExifQImage(preview, orientation) &&
+                     setImagePreview(preview, false);
+            }
+        }
+
+        // -- Dimensions and regions -----------------------------------
+
+        if (ok && orientation >= ORIENTATION_ROT_90_HFLIP)
+        {
+            const QSize size = getImageDimensions();
+
+            if (size.isValid())
+            {
+                ok = setImageDimensions(size.transposed(), false);
+            }
+        }
+
+        ok = ok && transformXmpRegions(orientation, false);
+        ok = ok && setImageOrientation(ORIENTATION_NORMAL, false);
+    }
+    catch( Exiv2::Error& e )
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot normalize orientation using Exiv2 "), e);
+        ok = false;
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+        ok = false;
+    }
+
+    if (!ok)
+    {
+        d->data               = backup;
+        d->pendingProgramId   = pendingProgramId;
+        d->pendingIptcCharset = pendingIptcCharset;
+    }
+
+    commitEdit();
+
+    if (!ok)
+        return RotationMatrix();
+
+    qCDebug(LIBKEXIV2_LOG) << "Metadata normalized from orientation" << (int)orientation;
+
+    return RotationMatrix(orientation);
+}
+
 KExiv2::ImageColorWorkSpace KExiv2::getImageColorWorkSpace() const
 {
     // Check Exif values.
@@ -514,7 +606,7 @@ KExiv2::ImageColorWorkSpace KExiv2::getImageColorWorkSpace() const
 
 bool KExiv2::setImageColorWorkSpace(ImageColorWorkSpace workspace, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -545,257 +637,190 @@ bool KExiv2::setImageColorWorkSpace(ImageColorWorkSpace workspace, bool setProgr
     return false;
 }
 
-QDateTime KExiv2::getImageDateTime() const
+/** Exif date and time tags with their SubSecTime and OffsetTime companions, in the priority order
+ *  used to get the image date and time.
+ */
+enum ExifDateTimeTag
 {
-    try
+    ExifDateTimeOriginal = 0,
+    ExifDateTimeDigitized,
+    ExifDateTime,
+    ExifDateTimeTagCount
+};
+
+struct ExifDateTimeTags
+{
+    const Exiv2::Exifdatum* dateTime[ExifDateTimeTagCount] = { nullptr, nullptr, nullptr };
+    const Exiv2::Exifdatum* subSec[ExifDateTimeTagCount]   = { nullptr, nullptr, nullptr };
+    const Exiv2::Exifdatum* offset[ExifDateTimeTagCount]   = { nullptr, nullptr, nullptr };
+};
+
+/** Collect all Exif date and time tags in a single pass, instead of a findKey() call per tag.
+ */
+static ExifDateTimeTags findExifDateTimeTags(const Exiv2::ExifData& exifData)
+{
+    ExifDateTimeTags tags;
+
+    for (Exiv2::ExifData::const_iterator it = exifData.begin(); it != exifData.end(); ++it)
     {
-        // In first, trying to get Date & time from Exif tags.
+        const uint16_t tag = it->tag();
 
-        if (!d->exifMetadata().empty())
+        if (tag == 0x0132)
         {
-            Exiv2::ExifData exifData(d->exifMetadata());
-            {
-                Exiv2::ExifKey key("Exif.Photo.DateTimeOriginal");
-                Exiv2::ExifData::iterator it = exifData.findKey(key);
+            // Exif.Image.DateTime, not to be mixed up with the one of the thumbnail IFD.
 
-                if (it != exifData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+            if (!tags.dateTime[ExifDateTime] && it->groupName() == "Image")
+                tags.dateTime[ExifDateTime] = &(*it);
 
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Exif.Photo.DateTimeOriginal => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }
-            {
-                Exiv2::ExifKey key("Exif.Photo.DateTimeDigitized");
-                Exiv2::ExifData::iterator it = exifData.findKey(key);
-
-                if (it != exifData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
-
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Exif.Photo.DateTimeDigitized => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }
-            {
-                Exiv2::ExifKey key("Exif.Image.DateTime");
-                Exiv2::ExifData::iterator it = exifData.findKey(key);
+            continue;
+        }
 
-                if (it != exifData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+        if ((tag < 0x9003 || tag > 0x9292) || it->groupName() != "Photo")
+            continue;
 
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Exif.Image.DateTime => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }
+        switch (tag)
+        {
+            case 0x9003:        // Exif.Photo.DateTimeOriginal
+                tags.dateTime[ExifDateTimeOriginal]  = &(*it);
+                break;
+            case 0x9004:        // Exif.Photo.DateTimeDigitized
+                tags.dateTime[ExifDateTimeDigitized] = &(*it);
+                break;
+            case 0x9010:        // Exif.Photo.OffsetTime
+                tags.offset[ExifDateTime]            = &(*it);
+                break;
+            case 0x9011:        // Exif.Photo.OffsetTimeOriginal
+                tags.offset[ExifDateTimeOriginal]    = &(*it);
+                break;
+            case 0x9012:        // Exif.Photo.OffsetTimeDigitized
+                tags.offset[ExifDateTimeDigitized]   = &(*it);
+                break;
+            case 0x9290:        // Exif.Photo.SubSecTime
+                tags.subSec[ExifDateTime]            = &(*it);
+                break;
+            case 0x9291:        // Exif.Photo.SubSecTimeOriginal
+                tags.subSec[ExifDateTimeOriginal]    = &(*it);
+                break;
+            case 0x9292:        // Exif.Photo.SubSecTimeDigitized
+                tags.subSec[ExifDateTimeDigitized]   = &(*it);
+                break;
+            default:
+                break;
         }
+    }
 
-        // In second, trying to get Date & time from Xmp tags.
+    return tags;
+}
 
+/** Returns the first valid date and time found in the list of XMP keys.
+ */
 #ifdef _XMP_SUPPORT_
+static QDateTime findXmpDateTime(const Exiv2::XmpData& xmpData, const char* const* const keys, int count)
+{
+    for (int i = 0 ; i < count ; ++i)
+    {
+        Exiv2::XmpKey key(keys[i]);
+        Exiv2::XmpData::const_iterator it = xmpData.findKey(key);
 
-        if (!d->xmpMetadata().empty())
+        if (it != xmpData.end())
         {
-            Exiv2::XmpData xmpData(d->xmpMetadata());
-            {
-                Exiv2::XmpKey key("Xmp.exif.DateTimeOriginal");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
-
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+            QDateTime dateTime = KExiv2Private::convertDateTimeValue(it->value());
 
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.exif.DateTimeOriginal => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }
+            if (dateTime.isValid())
             {
-                Exiv2::XmpKey key("Xmp.exif.DateTimeDigitized");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
-
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
-
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.exif.DateTimeDigitized => " << dateTime;
-                        return dateTime;
-                    }
-                }
+                qCDebug(LIBKEXIV2_LOG) << "DateTime =>" << keys[i] << "=>" << dateTime;
+                return dateTime;
             }
-            {
-                Exiv2::XmpKey key("Xmp.photoshop.DateCreated");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
-
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+        }
+    }
 
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.photoshop.DateCreated => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }
-            {
-                Exiv2::XmpKey key("Xmp.xmp.CreateDate");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
+    return QDateTime();
+}
+#endif // _XMP_SUPPORT_
 
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+QDateTime KExiv2::getImageDateTime() const
+{
+    try
+    {
+        // In first, trying to get Date & time from Exif tags.
 
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.xmp.CreateDate => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }
+        if (!std::as_const(*d).exifMetadata().empty())
+        {
+            static const char* const exifKeys[ExifDateTimeTagCount] =
             {
-                Exiv2::XmpKey key("Xmp.tiff.DateTime");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
+                "Exif.Photo.DateTimeOriginal",
+                "Exif.Photo.DateTimeDigitized",
+                "Exif.Image.DateTime"
+            };
 
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+            const ExifDateTimeTags tags = findExifDateTimeTags(std::as_const(*d).exifMetadata());
 
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.tiff.DateTime => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }
+            for (int i = 0 ; i < ExifDateTimeTagCount ; ++i)
             {
-                Exiv2::XmpKey key("Xmp.xmp.ModifyDate");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
-
-                if (it != xmpData.end())
+                if (tags.dateTime[i])
                 {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+                    QDateTime dateTime = KExiv2Private::convertExifDateTime(*tags.dateTime[i], tags.subSec[i], tags.offset[i]);
 
                     if (dateTime.isValid())
                     {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.xmp.ModifyDate => " << dateTime;
+                        qCDebug(LIBKEXIV2_LOG) << "DateTime =>" << exifKeys[i] << "=>" << dateTime;
                         return dateTime;
                     }
                 }
             }
-            {
-                Exiv2::XmpKey key("Xmp.xmp.MetadataDate");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
-
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+        }
 
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.xmp.MetadataDate => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }
-            
-            // Video files support
-            
-            {
-                Exiv2::XmpKey key("Xmp.video.DateTimeOriginal");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
+        // In second, trying to get Date & time from Xmp tags.
 
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+#ifdef _XMP_SUPPORT_
 
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.video.DateTimeOriginal => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }
+        if (!std::as_const(*d).xmpMetadata().empty())
+        {
+            static const char* const xmpKeys[] =
             {
-                Exiv2::XmpKey key("Xmp.video.DateUTC");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
-
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
-
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.video.DateUTC => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }
+                "Xmp.exif.DateTimeOriginal",
+                "Xmp.exif.DateTimeDigitized",
+                "Xmp.photoshop.DateCreated",
+                "Xmp.xmp.CreateDate",
+                "Xmp.tiff.DateTime",
+                "Xmp.xmp.ModifyDate",
+                "Xmp.xmp.MetadataDate",
+
+                // Video files support
+
+                "Xmp.video.DateTimeOriginal",
+                "Xmp.video.DateUTC",
+                "Xmp.video.ModificationDate",
+                "Xmp.video.DateTimeDigitized"
+            };
+
+            QDateTime dateTime = findXmpDateTime(std::as_const(*d).xmpMetadata(), xmpKeys,
+                                                 sizeof(xmpKeys) / sizeof(xmpKeys[0]));
+
+            if (dateTime.isValid())
             {
-                Exiv2::XmpKey key("Xmp.video.ModificationDate");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
-
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
-
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.video.ModificationDate => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }            
-            {
-                Exiv2::XmpKey key("Xmp.video.DateTimeDigitized");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
-
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
-
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime => Xmp.video.DateTimeDigitized => " << dateTime;
-                        return dateTime;
-                    }
-                }
-            }  
+                return dateTime;
+            }
         }
 
 #endif // _XMP_SUPPORT_
 
         // In third, trying to get Date & time from Iptc tags.
 
-        if (!d->iptcMetadata().empty())
+        if (!std::as_const(*d).iptcMetadata().empty())
         {
-            Exiv2::IptcData iptcData(d->iptcMetadata());
+            const Exiv2::IptcData& iptcData(std::as_const(*d).iptcMetadata());
 
             // Try creation Iptc date & time entries.
 
             Exiv2::IptcKey keyDateCreated("Iptc.Application2.DateCreated");
-            Exiv2::IptcData::iterator it = iptcData.findKey(keyDateCreated);
+            Exiv2::IptcData::const_iterator it = iptcData.findKey(keyDateCreated);
 
             if (it != iptcData.end())
             {
                 QString IptcDateCreated(QString::fromLatin1(it->toString().c_str()));
                 Exiv2::IptcKey keyTimeCreated("Iptc.Application2.TimeCreated");
-                Exiv2::IptcData::iterator it2 = iptcData.findKey(keyTimeCreated);
+                Exiv2::IptcData::const_iterator it2 = iptcData.findKey(keyTimeCreated);
 
                 if (it2 != iptcData.end())
                 {
@@ -815,13 +840,13 @@ QDateTime KExiv2::getImageDateTime() const
             // Try digitization Iptc date & time entries.
 
             Exiv2::IptcKey keyDigitizationDate("Iptc.Application2.DigitizationDate");
-            Exiv2::IptcData::iterator it3 = iptcData.findKey(keyDigitizationDate);
+            Exiv2::IptcData::const_iterator it3 = iptcData.findKey(keyDigitizationDate);
 
             if (it3 != iptcData.end())
             {
                 QString IptcDateDigitization(QString::fromLatin1(it3->toString().c_str()));
                 Exiv2::IptcKey keyDigitizationTime("Iptc.Application2.DigitizationTime");
-                Exiv2::IptcData::iterator it4 = iptcData.findKey(keyDigitizationTime);
+                Exiv2::IptcData::const_iterator it4 = iptcData.findKey(keyDigitizationTime);
 
                 if (it4 != iptcData.end())
                 {
@@ -856,7 +881,7 @@ bool KExiv2::setImageDateTime(const QDateTime& dateTime, bool setDateTimeDigitiz
     if(!dateTime.isValid())
         return false;
 
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -942,17 +967,17 @@ QDateTime KExiv2::getDigitizationDateTime(bool fallbackToCreationTime) const
     {
         // In first, trying to get Date & time from Exif tags.
 
-        if (!d->exifMetadata().empty())
+        if (!std::as_const(*d).exifMetadata().empty())
         {
             // Try Exif date time digitized.
 
-            Exiv2::ExifData exifData(d->exifMetadata());
-            Exiv2::ExifKey key("Exif.Photo.DateTimeDigitized");
-            Exiv2::ExifData::iterator it = exifData.findKey(key);
+            const ExifDateTimeTags tags = findExifDateTimeTags(std::as_const(*d).exifMetadata());
 
-            if (it != exifData.end())
+            if (tags.dateTime[ExifDateTimeDigitized])
             {
-                QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+                QDateTime dateTime = KExiv2Private::convertExifDateTime(*tags.dateTime[ExifDateTimeDigitized],
+                                                                        tags.subSec[ExifDateTimeDigitized],
+                                                                        tags.offset[ExifDateTimeDigitized]);
 
                 if (dateTime.isValid())
                 {
@@ -966,59 +991,41 @@ QDateTime KExiv2::getDigitizationDateTime(bool fallbackToCreationTime) const
 
 #ifdef _XMP_SUPPORT_
 
-        if (!d->xmpMetadata().empty())
+        if (!std::as_const(*d).xmpMetadata().empty())
         {
-            Exiv2::XmpData xmpData(d->xmpMetadata());
+            static const char* const xmpKeys[] =
             {
-                Exiv2::XmpKey key("Xmp.exif.DateTimeDigitized");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
+                "Xmp.exif.DateTimeDigitized",
+                "Xmp.video.DateTimeDigitized"
+            };
 
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+            QDateTime dateTime = findXmpDateTime(std::as_const(*d).xmpMetadata(), xmpKeys,
+                                                 sizeof(xmpKeys) / sizeof(xmpKeys[0]));
 
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime (XMP-Exif digitalized): " << dateTime.toString().toLatin1().constData();
-                        return dateTime;
-                    }
-                }
-            }           
+            if (dateTime.isValid())
             {
-                Exiv2::XmpKey key("Xmp.video.DateTimeDigitized");
-                Exiv2::XmpData::iterator it = xmpData.findKey(key);
-
-                if (it != xmpData.end())
-                {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
-
-                    if (dateTime.isValid())
-                    {
-                        qCDebug(LIBKEXIV2_LOG) << "DateTime (XMP-Video digitalized): " << dateTime.toString().toLatin1().constData();
-                        return dateTime;
-                    }
-                }
-            }  
+                return dateTime;
+            }
         }
         
 #endif // _XMP_SUPPORT_
         
         // In third, trying to get Date & time from Iptc tags.
 
-        if (!d->iptcMetadata().empty())
+        if (!std::as_const(*d).iptcMetadata().empty())
         {
             // Try digitization Iptc date time entries.
 
-            Exiv2::IptcData iptcData(d->iptcMetadata());
+            const Exiv2::IptcData& iptcData(std::as_const(*d).iptcMetadata());
             Exiv2::IptcKey keyDigitizationDate("Iptc.Application2.DigitizationDate");
-            Exiv2::IptcData::iterator it = iptcData.findKey(keyDigitizationDate);
+            Exiv2::IptcData::const_iterator it = iptcData.findKey(keyDigitizationDate);
 
             if (it != iptcData.end())
             {
                 QString IptcDateDigitization(QString::fromLatin1(it->toString().c_str()));
 
                 Exiv2::IptcKey keyDigitizationTime("Iptc.Application2.DigitizationTime");
-                Exiv2::IptcData::iterator it2 = iptcData.findKey(keyDigitizationTime);
+                Exiv2::IptcData::const_iterator it2 = iptcData.findKey(keyDigitizationTime);
 
                 if (it2 != iptcData.end())
                 {
@@ -1052,6 +1059,52 @@ QDateTime KExiv2::getDigitizationDateTime(bool fallbackToCreationTime) const
         return QDateTime();
 }
 
+QDateTime KExiv2::convertFromDateTimeString(const QString& dateTime, const QString& subSecTime, const QString& offsetTime)
+{
+    QDateTime result;
+
+    if (!KExiv2Private::parseDateTime(dateTime.constData(), dateTime.size(), result))
+    {
+        result = QDateTime::fromString(dateTime, Qt::ISODate);
+    }
+
+    if (!result.isValid() || (subSecTime.isEmpty() && offsetTime.isEmpty()))
+    {
+        return result;
+    }
+
+    return KExiv2Private::mergeSubSecAndOffset(result,
+                                               subSecTime.constData(), subSecTime.size(),
+                                               offsetTime.constData(), offsetTime.size());
+}
+
+QList<QDateTime> KExiv2::convertFromDateTimeStrings(const QStringList& dateTimes,
+                                                    const QStringList& subSecTimes,
+                                                    const QStringList& offsetTimes)
+{
+    QList<QDateTime> result;
+    result.reserve(dateTimes.size());
+
+    const bool hasSubSec = !subSecTimes.isEmpty();
+    const bool hasOffset = !offsetTimes.isEmpty();
+
+    for (int i = 0 ; i < dateTimes.size() ; ++i)
+    {
+        if (!hasSubSec && !hasOffset)
+        {
+            result.append(convertFromDateTimeString(dateTimes.at(i)));
+        }
+        else
+        {
+            result.append(convertFromDateTimeString(dateTimes.at(i),
+                                                    hasSubSec ? subSecTimes.value(i) : QString(),
+                                                    hasOffset ? offsetTimes.value(i) : QString()));
+        }
+    }
+
+    return result;
+}
+
 bool KExiv2::getImagePreview(QImage& preview) const
 {
     try
@@ -1074,9 +1127,271 @@ bool KExiv2::getImagePreview(QImage& preview) const
     return false;
 }
 
+/** An embedded image which can be used as thumbnail.
+ */
+struct ThumbnailSource
+{
+    QByteArray                  data;
+    QByteArray                  format;
+    QSize                       size;
+    KExiv2::ImageOrientation    orientation = KExiv2::ORIENTATION_UNSPECIFIED;
+};
+
+/** Returns \a size in the orientation of the stored pixels of an image with the Exif \a orientation.
+ */
+static QSize storedSize(const QSize& size, KExiv2::ImageOrientation orientation)
+{
+    if (orientation >= KExiv2::ORIENTATION_ROT_90_HFLIP && orientation <= KExiv2::ORIENTATION_ROT_270)
+        return size.transposed();
+
+    return size;
+}
+
+/** Returns true if the stored pixels of the \a source are enough to render the \a targetSize.
+ */
+static bool coversTarget(const ThumbnailSource& source, const QSize& targetSize)
+{
+    if (!targetSize.isValid())
+        return false;
+
+    const QSize target = storedSize(targetSize, source.orientation);
+
+    return (source.size.width() >= target.width() && source.size.height() >= target.height());
+}
+
+/** Reads the pixel size of the \a source from its header, without decoding it.
+ */
+static void readSourceSize(ThumbnailSource& source)
+{
+    QBuffer buffer;
+    buffer.setData(source.data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImageReader reader(&buffer, source.format);
+    source.size = reader.size();
+}
+
+QImage KExiv2::bestThumbnail(const QSize& targetSize) const
+{
+    QList<ThumbnailSource> sources;
+    ImageOrientation       orientation = ORIENTATION_UNSPECIFIED;
+
+    try
+    {
+        orientation = getImageOrientation();
+
+        const Exiv2::ExifData& exifData = std::as_const(*d).exifMetadata();
+
+        // Exif IFD1 thumbnail. It can have its own orientation tag.
+
+        if (!exifData.empty())
+        {
+            Exiv2::ExifThumbC thumb(exifData);
+            Exiv2::DataBuf const buf = thumb.copy();
+            ThumbnailSource source;
+#if EXIV2_TEST_VERSION(0,28,0)
+            source.data        = QByteArray((const char*)buf.c_data(), buf.size());
+#else
+            source.data        = QByteArray((const char*)buf.pData_, buf.size_);
+#endif
+            source.format      = QByteArray(thumb.extension()).mid(1);
+            source.orientation = orientation;
+
+            Exiv2::ExifData::const_iterator it = exifData.findKey(Exiv2::ExifKey("Exif.Thumbnail.Orientation"));
+
+            if (it != exifData.end() && it->count())
+            {
+#if EXIV2_TEST_VERSION(0,28,0)
+                const long thumbOrientation = it->toUint32();
+#else
+                const long thumbOrientation = it->toLong();
+#endif
+
+                if (thumbOrientation >= ORIENTATION_FIRST_VALUE && thumbOrientation <= ORIENTATION_LAST_VALUE)
+                    source.orientation = (ImageOrientation)thumbOrientation;
+            }
+
+            if (!source.data.isEmpty())
+                sources << source;
+        }
+
+        // IPTC preview. See https://www.iptc.org/std/IIM/4.1/specification/IIMV4.1.pdf Appendix A
+        // for the format values.
+
+        ThumbnailSource source;
+        source.data        = getIptcTagData("Iptc.Application2.Preview");
+        source.orientation = orientation;
+
+        const Exiv2::IptcData& iptcData    = std::as_const(*d).iptcMetadata();
+        Exiv2::IptcData::const_iterator it = iptcData.findKey(Exiv2::IptcKey("Iptc.Application2.PreviewFormat"));
+
+        if (it != iptcData.end() && it->count())
+        {
+#if EXIV2_TEST_VERSION(0,28,0)
+            const long format = it->toUint32();
+#else
+            const long format = it->toLong();
+#endif
+
+            if      (format == 11)
+                source.format = "jpeg";
+            else if (format == 3)
+                source.format = "tiff";
+        }
+
+        if (!source.data.isEmpty())
+            sources << source;
+    }
+    catch( Exiv2::Error& e )
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot get thumbnail using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+    // The smallest embedded image large enough for the target size, else the largest one.
+
+    int best = -1;
+
+    for (int i = 0 ; i < sources.size() ; ++i)
+    {
+        readSourceSize(sources[i]);
+
+        if (!sources[i].size.isValid())
+            continue;
+
+        if (best == -1)
+        {
+            best = i;
+            continue;
+        }
+
+        const bool covers     = coversTarget(sources[i],    targetSize);
+        const bool bestCovers = coversTarget(sources[best], targetSize);
+        const qint64 pixels     = (qint64)sources[i].size.width()    * sources[i].size.height();
+        const qint64 bestPixels = (qint64)sources[best].size.width() * sources[best].size.height();
+
+        if ((covers && (!bestCovers || pixels < bestPixels)) || (!covers && !bestCovers && pixels > bestPixels))
+            best = i;
+    }
+
+    QImage image;
+
+    if (best != -1 && coversTarget(sources[best], targetSize))
+    {
+        const ThumbnailSource& source = sources[best];
+        image                         = KExiv2Private::loadScaledImage(source.data, storedSize(targetSize, source.orientation),
+                                                                       source.format);
+        orientation                   = source.orientation;
+    }
+    else
+    {
+        // The images embedded in the metadata are too small: look at the previews of the file,
+        // reusing the metadata already parsed.
+
+        KExiv2Previews previews(*this);
+        const int index = targetSize.isValid() ? previews.indexForSize(storedSize(targetSize, orientation))
+                                               : (previews.isEmpty() ? -1 : 0);
+
+        if (index != -1 && (best == -1 ||
+                            (qint64)previews.width(index) * previews.height(index) >
+                            (qint64)sources[best].size.width() * sources[best].size.height()))
+        {
+            image = previews.image(index, storedSize(targetSize, orientation));
+        }
+        else if (best != -1)
+        {
+            const ThumbnailSource& source = sources[best];
+            image                         = KExiv2Private::loadScaledImage(source.data, storedSize(targetSize, source.orientation),
+                                                                           source.format);
+            orientation                   = source.orientation;
+        }
+    }
+
+    if (!image.isNull())
+        rotateExifQImage(image, orientation);
+
+    return image;
+}
+
+/** The lowest JPEG quality tried by encodeJpeg().
+ */
+static const int s_minJpegQuality   = 10;
+
+QByteArray KExiv2::encodeJpeg(const QImage& image, int maxSize, int maxQuality, int* const quality)
+{
+    if (image.isNull() || maxSize <= 0)
+        return QByteArray();
+
+    maxQuality = qBound(s_minJpegQuality, maxQuality, 100);
+
+    // All encodings write in the same buffer: opening it write only truncates it
+    // and keeps its capacity.
+
+    QByteArray data;
+    data.reserve(maxSize);
+    QBuffer buffer(&data);
+
+    const auto encode = [&image, &data, &buffer](int jpegQuality)
+    {
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "JPEG", jpegQuality);
+        buffer.close();
+
+        return data.size();
+    };
+
+    int best = -1;
+    int last = maxQuality;
+
+    if (encode(maxQuality) <= maxSize)
+    {
+        best = maxQuality;
+    }
+    else
+    {
+        // Binary search of the highest quality under the size limit. The range is
+        // searched entirely, which takes at most 7 encodings for the default qualities.
+
+        int low  = s_minJpegQuality;
+        int high = maxQuality - 1;
+
+        while (low <= high)
+        {
+            last = (low + high) / 2;
+
+            if (encode(last) <= maxSize)
+            {
+                best = last;
+                low  = last + 1;
+            }
+            else
+            {
+                high = last - 1;
+            }
+        }
+    }
+
+    if (best == -1)
+    {
+        qCDebug(LIBKEXIV2_LOG) << "Cannot encode a JPEG image of" << image.size() << "pixels in" << maxSize << "bytes";
+        return QByteArray();
+    }
+
+    if (last != best)
+        encode(best);
+
+    if (quality)
+        *quality = best;
+
+    return data;
+}
+
 bool KExiv2::setImagePreview(const QImage& preview, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     if (preview.isNull())
@@ -1089,17 +1404,21 @@ bool KExiv2::setImagePreview(const QImage& preview, bool setProgramName) const
 
     try
     {
-        QByteArray data;
-        QBuffer buffer(&data);
-        buffer.open(QIODevice::WriteOnly);
+        // Compress the preview as needed to fit the IPTC size limits.
+        int quality           = 0;
+        const QByteArray data = encodeJpeg(preview, d->iptcPreviewMaxSize(), 75, &quality);
+
+        if (data.isEmpty())
+        {
+            qCDebug(LIBKEXIV2_LOG) << "JPEG image preview of" << preview.size() << "pixels too large for IPTC";
+            return false;
+        }
 
-        // A little bit compressed preview jpeg image to limit IPTC size.
-        preview.save(&buffer, "JPEG");
         qCDebug(LIBKEXIV2_LOG) << "JPEG image preview size: (" << preview.width() << " x "
-                 << preview.height() << ") pixels - " << data.size() << " bytes";
+                 << preview.height() << ") pixels - " << data.size() << " bytes - quality " << quality;
 
         Exiv2::DataValue val;
-        val.read((Exiv2::byte *)data.data(), data.size());
+        val.read((const Exiv2::byte *)data.constData(), data.size());
         d->iptcMetadata()["Iptc.Application2.Preview"] = val;
 
         // See https://www.iptc.org/std/IIM/4.1/specification/IIMV4.1.pdf Appendix A for details.
@@ -50,7 +50,7 @@ bool KExiv2::canWriteIptc(const QString& filePath)
 
 bool KExiv2::hasIptc() const
 {
-    return !d->iptcMetadata().empty();
+    return !std::as_const(*d).iptcMetadata().empty();
 }
 
 bool KExiv2::clearIptc() const
@@ -76,9 +76,9 @@ QByteArray KExiv2::getIptc(bool addIrbHeader) const
 {
     try
     {
-        if (!d->iptcMetadata().empty())
+        if (!std::as_const(*d).iptcMetadata().empty())
         {
-            Exiv2::IptcData& iptc = d->iptcMetadata();
+            const Exiv2::IptcData& iptc = std::as_const(*d).iptcMetadata();
             Exiv2::DataBuf c2;
 
             if (addIrbHeader)
@@ -87,7 +87,7 @@ QByteArray KExiv2::getIptc(bool addIrbHeader) const
             }
             else
             {
-                c2 = Exiv2::IptcParser::encode(d->iptcMetadata());
+                c2 = Exiv2::IptcParser::encode(iptc);
             }
 
 #if EXIV2_TEST_VERSION(0,28,0)
@@ -123,7 +123,7 @@ bool KExiv2::setIptc(const QByteArray& data) const
         if (!data.isEmpty())
         {
             Exiv2::IptcParser::decode(d->iptcMetadata(), (const Exiv2::byte*)data.data(), data.size());
-            return (!d->iptcMetadata().empty());
+            return (!std::as_const(*d).iptcMetadata().empty());
         }
     }
     catch(Exiv2::Error& e)
@@ -145,12 +145,12 @@ bool KExiv2::setIptc(const QByteArray& data) const
 
 KExiv2::MetaDataMap KExiv2::getIptcTagsDataList(const QStringList& iptcKeysFilter, bool invertSelection) const
 {
-    if (d->iptcMetadata().empty())
+    if (std::as_const(*d).iptcMetadata().empty())
        return MetaDataMap();
 
     try
     {
-        Exiv2::IptcData iptcData = d->iptcMetadata();
+        Exiv2::IptcData iptcData = std::as_const(*d).iptcMetadata();
         iptcData.sortByKey();
 
         QString     ifDItemName;
@@ -293,7 +293,7 @@ QString KExiv2::getIptcTagDescription(const char* iptcTagName)
 
 bool KExiv2::removeIptcTag(const char* iptcTagName, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -336,7 +336,7 @@ bool KExiv2::setIptcTagData(const char* iptcTagName, const QByteArray& data, boo
     if (data.isEmpty())
         return false;
 
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -362,15 +362,13 @@ QByteArray KExiv2::getIptcTagData(const char* iptcTagName) const
     try
     {
         Exiv2::IptcKey  iptcKey(iptcTagName);
-        Exiv2::IptcData iptcData(d->iptcMetadata());
-        Exiv2::IptcData::iterator it = iptcData.findKey(iptcKey);
+        const Exiv2::IptcData& iptcData = std::as_const(*d).iptcMetadata();
+        Exiv2::IptcData::const_iterator it = iptcData.findKey(iptcKey);
 
         if (it != iptcData.end())
         {
-            char* const s = new char[(*it).size()];
-            (*it).copy((Exiv2::byte*)s, Exiv2::bigEndian);
-            QByteArray data(s, (*it).size());
-            delete [] s;
+            QByteArray data((int)(*it).size(), Qt::Uninitialized);
+            (*it).copy((Exiv2::byte*)data.data(), Exiv2::bigEndian);
             return data;
         }
     }
@@ -386,19 +384,51 @@ QByteArray KExiv2::getIptcTagData(const char* iptcTagName) const
     return QByteArray();
 }
 
+QByteArrayView KExiv2::getIptcTagDataView(const char* iptcTagName) const
+{
+    try
+    {
+        Exiv2::IptcKey iptcKey(iptcTagName);
+        const Exiv2::IptcData& iptcData = std::as_const(*d).iptcMetadata();
+        Exiv2::IptcData::const_iterator it = iptcData.findKey(iptcKey);
+
+        if (it != iptcData.end())
+        {
+            // Only the text values are stored by Exiv2 as they are written in the file. Comment
+            // values are excluded: their copy() converts the byte order of Unicode comments.
+            const Exiv2::StringValueBase* const str = dynamic_cast<const Exiv2::StringValueBase*>(&(*it).value());
+
+            if (str && (*it).typeId() != Exiv2::comment)
+            {
+                return QByteArrayView(str->value_.data(), (qsizetype)str->value_.size());
+            }
+
+            qCDebug(LIBKEXIV2_LOG) << "Cannot view the data of Iptc key" << iptcTagName << ": not a text value";
+        }
+    }
+    catch( Exiv2::Error& e )
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot find Iptc key '%1' into image using Exiv2 ").arg(QString::fromLatin1(iptcTagName)), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+    return QByteArrayView();
+}
+
 QString KExiv2::getIptcTagString(const char* iptcTagName, bool escapeCR) const
 {
     try
     {
         Exiv2::IptcKey  iptcKey(iptcTagName);
-        Exiv2::IptcData iptcData(d->iptcMetadata());
-        Exiv2::IptcData::iterator it = iptcData.findKey(iptcKey);
+        const Exiv2::IptcData& iptcData(std::as_const(*d).iptcMetadata());
+        Exiv2::IptcData::const_iterator it = iptcData.findKey(iptcKey);
 
         if (it != iptcData.end())
         {
-            std::ostringstream os;
-            os << *it;
-            QString tagValue(QString::fromLatin1(os.str().c_str()));
+            QString tagValue = d->convertIptcValue(*it, false);
 
             if (escapeCR)
                 tagValue.replace(QString::fromLatin1("\n"), QString::fromLatin1(" "));
@@ -420,7 +450,7 @@ QString KExiv2::getIptcTagString(const char* iptcTagName, bool escapeCR) const
 
 bool KExiv2::setIptcTagString(const char* iptcTagName, const QString& value, bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -428,7 +458,7 @@ bool KExiv2::setIptcTagString(const char* iptcTagName, const QString& value, boo
         d->iptcMetadata()[iptcTagName] = std::string(value.toUtf8().constData());
 
         // Make sure we have set the charset to UTF-8
-        d->iptcMetadata()["Iptc.Envelope.CharacterSet"] = "\33%G";
+        d->setIptcCharsetUtf8();
         return true;
     }
     catch(Exiv2::Error& e)
@@ -447,18 +477,18 @@ QStringList KExiv2::getIptcTagsStringList(const char* iptcTagName, bool escapeCR
 {
     try
     {
-        if (!d->iptcMetadata().empty())
+        if (!std::as_const(*d).iptcMetadata().empty())
         {
             QStringList values;
-            Exiv2::IptcData iptcData(d->iptcMetadata());
+            const Exiv2::IptcData& iptcData(std::as_const(*d).iptcMetadata());
 
-            for (Exiv2::IptcData::iterator it = iptcData.begin(); it != iptcData.end(); ++it)
-            {
-                QString key = QString::fromLocal8Bit(it->key().c_str());
+            const Exiv2::IptcKey key(iptcTagName);
 
-                if (key == QString::fromLatin1(iptcTagName))
+            for (Exiv2::IptcData::const_iterator it = iptcData.begin(); it != iptcData.end(); ++it)
+            {
+                if (it->record() == key.record() && it->tag() == key.tag())
                 {
-                    QString tagValue = QString::fromUtf8(it->toString().c_str());
+                    QString tagValue = d->convertIptcValue(*it, true);
 
                     if (escapeCR)
                         tagValue.replace(QString::fromLatin1("\n"), QString::fromLatin1(" "));
@@ -486,57 +516,19 @@ bool KExiv2::setIptcTagsStringList(const char* iptcTagName, int maxSize,
                                    const QStringList& oldValues, const QStringList& newValues,
                                    bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
     {
-        QStringList oldvals = oldValues;
-        QStringList newvals = newValues;
-
         qCDebug(LIBKEXIV2_LOG) << d->filePath.toLatin1().constData() << " : " << iptcTagName
-                 << " => " << newvals.join(QString::fromLatin1(",")).toLatin1().constData();
-
-        // Remove all old values.
-        Exiv2::IptcData iptcData(d->iptcMetadata());
-        Exiv2::IptcData::iterator it = iptcData.begin();
-
-        while(it != iptcData.end())
-        {
-            QString key = QString::fromLocal8Bit(it->key().c_str());
-            QString val = QString::fromUtf8(it->toString().c_str());
-
-            // Also remove new values to avoid duplicates. They will be added again below.
-            if ( key == QString::fromLatin1(iptcTagName) &&
-                 (oldvals.contains(val) || newvals.contains(val))
-               )
-                it = iptcData.erase(it);
-            else
-                ++it;
-        };
-
-        // Add new values.
-
-        Exiv2::IptcKey iptcTag(iptcTagName);
-
-        for (QStringList::iterator it = newvals.begin(); it != newvals.end(); ++it)
-        {
-            QString key = *it;
-            key.truncate(maxSize);
+                 << " => " << newValues.join(QString::fromLatin1(",")).toLatin1().constData();
 
-#if EXIV2_TEST_VERSION(0,28,0)
-            Exiv2::Value::UniquePtr val = Exiv2::Value::create(Exiv2::string);
-#else
-            Exiv2::Value::AutoPtr val = Exiv2::Value::create(Exiv2::string);
-#endif
-            val->read(key.toUtf8().constData());
-            iptcData.add(iptcTag, val.get());
-        }
-
-        d->iptcMetadata() = iptcData;
+        // Also remove new values to avoid duplicates. They will be added again.
+        d->editIptcStringList(Exiv2::IptcKey(iptcTagName), maxSize, oldValues + newValues, newValues, false);
 
         // Make sure character set is UTF-8
-        setIptcTagString("Iptc.Envelope.CharacterSet", QString::fromLatin1("\33%G"), false);
+        d->setIptcCharsetUtf8();
 
         return true;
     }
@@ -556,18 +548,18 @@ QStringList KExiv2::getIptcKeywords() const
 {
     try
     {
-        if (!d->iptcMetadata().empty())
+        if (!std::as_const(*d).iptcMetadata().empty())
         {
             QStringList keywords;
-            Exiv2::IptcData iptcData(d->iptcMetadata());
+            const Exiv2::IptcData& iptcData(std::as_const(*d).iptcMetadata());
 
-            for (Exiv2::IptcData::iterator it = iptcData.begin(); it != iptcData.end(); ++it)
-            {
-                QString key = QString::fromLocal8Bit(it->key().c_str());
+            const Exiv2::IptcKey key("Iptc.Application2.Keywords");
 
-                if (key == QString::fromLatin1("Iptc.Application2.Keywords"))
+            for (Exiv2::IptcData::const_iterator it = iptcData.begin(); it != iptcData.end(); ++it)
+            {
+                if (it->record() == key.record() && it->tag() == key.tag())
                 {
-                    QString val = QString::fromUtf8(it->toString().c_str());
+                    QString val = d->convertIptcValue(*it, true);
                     keywords.append(val);
                 }
             }
@@ -592,62 +584,78 @@ QStringList KExiv2::getIptcKeywords() const
 bool KExiv2::setIptcKeywords(const QStringList& oldKeywords, const QStringList& newKeywords,
                              bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
     {
-        QStringList oldkeys = oldKeywords;
-        QStringList newkeys = newKeywords;
-
-        qCDebug(LIBKEXIV2_LOG) << d->filePath << " ==> New Iptc Keywords: " << newkeys;
+        qCDebug(LIBKEXIV2_LOG) << d->filePath << " ==> New Iptc Keywords: " << newKeywords;
 
-        // Remove all old keywords.
-        Exiv2::IptcData iptcData(d->iptcMetadata());
-        Exiv2::IptcData::iterator it = iptcData.begin();
+        // Also remove new keywords to avoid duplicates. They will be added again.
+        // Note that Keywords Iptc tag is limited to 64 char but can be redondant.
+        d->editIptcStringList(Exiv2::IptcKey("Iptc.Application2.Keywords"), 64,
+                              oldKeywords + newKeywords, newKeywords, false);
 
-        while(it != iptcData.end())
-        {
-            QString key = QString::fromLocal8Bit(it->key().c_str());
-            QString val = QString::fromUtf8(it->toString().c_str());
+        // Make sure character set is UTF-8
+        d->setIptcCharsetUtf8();
 
-            // Also remove new keywords to avoid duplicates. They will be added again below.
-            if ( key == QString::fromLatin1("Iptc.Application2.Keywords") &&
-                 (oldKeywords.contains(val) || newKeywords.contains(val))
-               )
-                it = iptcData.erase(it);
-            else
-                ++it;
-        };
+        return true;
+    }
+    catch(Exiv2::Error& e)
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot set Iptc Keywords into image using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
 
-        // Add new keywords. Note that Keywords Iptc tag is limited to 64 char but can be redondant.
+    return false;
+}
 
-        Exiv2::IptcKey iptcTag("Iptc.Application2.Keywords");
+bool KExiv2::addIptcKeywords(const QStringList& keywords, bool setProgramName) const
+{
+    if (!applyProgramId(setProgramName))
+        return false;
 
-        for (QStringList::iterator it = newkeys.begin(); it != newkeys.end(); ++it)
+    try
+    {
+        if (d->editIptcStringList(Exiv2::IptcKey("Iptc.Application2.Keywords"), 64,
+                                  QStringList(), keywords, true) > 0)
         {
-            QString key = *it;
-            key.truncate(64);
-
-#if EXIV2_TEST_VERSION(0,28,0)
-            Exiv2::Value::UniquePtr val = Exiv2::Value::create(Exiv2::string);
-#else
-            Exiv2::Value::AutoPtr val = Exiv2::Value::create(Exiv2::string);
-#endif
-            val->read(key.toUtf8().constData());
-            iptcData.add(iptcTag, val.get());
+            // Make sure character set is UTF-8
+            d->setIptcCharsetUtf8();
         }
 
-        d->iptcMetadata() = iptcData;
+        return true;
+    }
+    catch(Exiv2::Error& e)
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot add Iptc Keywords into image using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
 
-        // Make sure character set is UTF-8
-        setIptcTagString("Iptc.Envelope.CharacterSet", QString::fromLatin1("\33%G"), false);
+    return false;
+}
+
+bool KExiv2::removeIptcKeywords(const QStringList& keywords, bool setProgramName) const
+{
+    if (!applyProgramId(setProgramName))
+        return false;
+
+    try
+    {
+        d->editIptcStringList(Exiv2::IptcKey("Iptc.Application2.Keywords"), 64,
+                              keywords, QStringList(), false);
 
         return true;
     }
     catch(Exiv2::Error& e)
     {
-        d->printExiv2ExceptionError(QString::fromLatin1("Cannot set Iptc Keywords into image using Exiv2 "), e);
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot remove Iptc Keywords from image using Exiv2 "), e);
     }
     catch(...)
     {
@@ -661,18 +669,18 @@ QStringList KExiv2::getIptcSubjects() const
 {
     try
     {
-        if (!d->iptcMetadata().empty())
+        if (!std::as_const(*d).iptcMetadata().empty())
         {
             QStringList subjects;
-            Exiv2::IptcData iptcData(d->iptcMetadata());
+            const Exiv2::IptcData& iptcData(std::as_const(*d).iptcMetadata());
 
-            for (Exiv2::IptcData::iterator it = iptcData.begin(); it != iptcData.end(); ++it)
-            {
-                QString key = QString::fromLocal8Bit(it->key().c_str());
+            const Exiv2::IptcKey key("Iptc.Application2.Subject");
 
-                if (key == QString::fromLatin1("Iptc.Application2.Subject"))
+            for (Exiv2::IptcData::const_iterator it = iptcData.begin(); it != iptcData.end(); ++it)
+            {
+                if (it->record() == key.record() && it->tag() == key.tag())
                 {
-                    QString val(QString::fromLatin1(it->toString().c_str()));
+                    QString val = d->convertIptcValue(*it, false);
                     subjects.append(val);
                 }
             }
@@ -695,51 +703,17 @@ QStringList KExiv2::getIptcSubjects() const
 bool KExiv2::setIptcSubjects(const QStringList& oldSubjects, const QStringList& newSubjects,
                              bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
     {
-        QStringList oldDef = oldSubjects;
-        QStringList newDef = newSubjects;
-
-        // Remove all old subjects.
-        Exiv2::IptcData iptcData(d->iptcMetadata());
-        Exiv2::IptcData::iterator it = iptcData.begin();
-
-        while(it != iptcData.end())
-        {
-            QString key = QString::fromLocal8Bit(it->key().c_str());
-            QString val = QString::fromUtf8(it->toString().c_str());
-
-            if (key == QString::fromLatin1("Iptc.Application2.Subject") && oldDef.contains(val))
-                it = iptcData.erase(it);
-            else
-                ++it;
-        };
-
-        // Add new subjects. Note that Keywords Iptc tag is limited to 236 char but can be redondant.
-
-        Exiv2::IptcKey iptcTag("Iptc.Application2.Subject");
-
-        for (QStringList::iterator it = newDef.begin(); it != newDef.end(); ++it)
-        {
-            QString key = *it;
-            key.truncate(236);
-
-#if EXIV2_TEST_VERSION(0,28,0)
-            Exiv2::Value::UniquePtr val = Exiv2::Value::create(Exiv2::string);
-#else
-            Exiv2::Value::AutoPtr val = Exiv2::Value::create(Exiv2::string);
-#endif
-            val->read(key.toUtf8().constData());
-            iptcData.add(iptcTag, val.get());
-        }
-
-        d->iptcMetadata() = iptcData;
+        // Note that Subject Iptc tag is limited to 236 char but can be redondant.
+        d->editIptcStringList(Exiv2::IptcKey("Iptc.Application2.Subject"), 236,
+                              oldSubjects, newSubjects, false);
 
         // Make sure character set is UTF-8
-        setIptcTagString("Iptc.Envelope.CharacterSet", QString::fromLatin1("\33%G"), false);
+        d->setIptcCharsetUtf8();
 
         return true;
     }
@@ -759,18 +733,18 @@ QStringList KExiv2::getIptcSubCategories() const
 {
     try
     {
-        if (!d->iptcMetadata().empty())
+        if (!std::as_const(*d).iptcMetadata().empty())
         {
             QStringList subCategories;
-            Exiv2::IptcData iptcData(d->iptcMetadata());
+            const Exiv2::IptcData& iptcData(std::as_const(*d).iptcMetadata());
 
-            for (Exiv2::IptcData::iterator it = iptcData.begin(); it != iptcData.end(); ++it)
-            {
-                QString key = QString::fromLocal8Bit(it->key().c_str());
+            const Exiv2::IptcKey key("Iptc.Application2.SuppCategory");
 
-                if (key == QString::fromLatin1("Iptc.Application2.SuppCategory"))
+            for (Exiv2::IptcData::const_iterator it = iptcData.begin(); it != iptcData.end(); ++it)
+            {
+                if (it->record() == key.record() && it->tag() == key.tag())
                 {
-                    QString val(QString::fromLatin1(it->toString().c_str()));
+                    QString val = d->convertIptcValue(*it, false);
                     subCategories.append(val);
                 }
             }
@@ -793,52 +767,17 @@ QStringList KExiv2::getIptcSubCategories() const
 bool KExiv2::setIptcSubCategories(const QStringList& oldSubCategories, const QStringList& newSubCategories,
                                   bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
     {
-        QStringList oldkeys = oldSubCategories;
-        QStringList newkeys = newSubCategories;
-
-        // Remove all old Sub Categories.
-        Exiv2::IptcData iptcData(d->iptcMetadata());
-        Exiv2::IptcData::iterator it = iptcData.begin();
-
-        while(it != iptcData.end())
-        {
-            QString key = QString::fromLocal8Bit(it->key().c_str());
-            QString val = QString::fromUtf8(it->toString().c_str());
-
-            if (key == QString::fromLatin1("Iptc.Application2.SuppCategory") && oldSubCategories.contains(val))
-                it = iptcData.erase(it);
-            else
-                ++it;
-        };
-
-        // Add new Sub Categories. Note that SubCategories Iptc tag is limited to 32
-        // characters but can be redondant.
-
-        Exiv2::IptcKey iptcTag("Iptc.Application2.SuppCategory");
-
-        for (QStringList::iterator it = newkeys.begin(); it != newkeys.end(); ++it)
-        {
-            QString key = *it;
-            key.truncate(32);
-
-#if EXIV2_TEST_VERSION(0,28,0)
-            Exiv2::Value::UniquePtr val = Exiv2::Value::create(Exiv2::string);
-#else
-            Exiv2::Value::AutoPtr val = Exiv2::Value::create(Exiv2::string);
-#endif
-            val->read(key.toUtf8().constData());
-            iptcData.add(iptcTag, val.get());
-        }
-
-        d->iptcMetadata() = iptcData;
+        // Note that SubCategories Iptc tag is limited to 32 characters but can be redondant.
+        d->editIptcStringList(Exiv2::IptcKey("Iptc.Application2.SuppCategory"), 32,
+                              oldSubCategories, newSubCategories, false);
 
         // Make sure character set is UTF-8
-        setIptcTagString("Iptc.Envelope.CharacterSet", QString::fromLatin1("\33%G"), false);
+        d->setIptcCharsetUtf8();
 
         return true;
     }
@@ -0,0 +1,653 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kexiv2keywordtree.h"
+
+// C++ includes
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+// Qt includes
+
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+
+// Local includes
+
+#include "kexiv2_p.h"
+#include "kexiv2.h"
+#include "libkexiv2_debug.h"
+
+namespace KExiv2Iface
+{
+
+/** The XMP tags holding the keywords.
+ */
+enum KeywordTag
+{
+    LightroomTag = 0,
+    DigiKamTag,
+    SubjectTag,
+    KeywordTags
+};
+
+static const char* const s_keywordKeys[KeywordTags] =
+{
+    "Xmp.lr.hierarchicalSubject",
+    "Xmp.digiKam.TagsList",
+    "Xmp.dc.subject"
+};
+
+static const QChar s_lightroomSeparator = QLatin1Char('|');
+static const QChar s_digiKamSeparator   = QLatin1Char('/');
+static const QChar s_escape             = QLatin1Char('\\');
+
+/** Splits \a path at the separators which are not escaped with a backslash. A backslash
+ *  escapes only the separator and itself, the other ones are part of the names.
+ */
+static QStringList splitPath(const QString& path, QChar separator)
+{
+    QStringList names;
+    QString     name;
+
+    for (int i = 0 ; i < path.size() ; ++i)
+    {
+        const QChar c = path.at(i);
+
+        if (c == s_escape && i + 1 < path.size() && (path.at(i + 1) == separator || path.at(i + 1) == s_escape))
+        {
+            name += path.at(++i);
+        }
+        else if (c == separator)
+        {
+            if (!name.isEmpty())
+                names << name;
+
+            name.clear();
+        }
+        else
+        {
+            name += c;
+        }
+    }
+
+    if (!name.isEmpty())
+        names << name;
+
+    return names;
+}
+
+/** Returns \a name as written in a path, where splitPath() reads it back.
+ */
+static QString escapedName(const QString& name, QChar separator)
+{
+    QString escaped;
+    escaped.reserve(name.size());
+
+    for (int i = 0 ; i < name.size() ; ++i)
+    {
+        const QChar c = name.at(i);
+
+        // A backslash is escaped only where it would be read as an escape.
+
+        if (c == separator ||
+            (c == s_escape && (i + 1 == name.size() || name.at(i + 1) == separator || name.at(i + 1) == s_escape)))
+        {
+            escaped += s_escape;
+        }
+
+        escaped += c;
+    }
+
+    return escaped;
+}
+
+#ifdef _XMP_SUPPORT_
+
+/** Returns true if the items of \a array are \a values, in the same order.
+ */
+static bool hasItems(const Exiv2::XmpArrayValue& array, const std::vector<std::string>& values)
+{
+    if (static_cast<size_t>(array.count()) != values.size())
+        return false;
+
+    for (size_t i = 0 ; i < values.size() ; ++i)
+    {
+        if (array.toString(i) != values[i])
+            return false;
+    }
+
+    return true;
+}
+
+/** Appends \a values to the items of \a array.
+ */
+static void appendItems(Exiv2::XmpArrayValue& array, const std::vector<std::string>& values)
+{
+    for (const std::string& item : values)
+    {
+        array.read(item);
+    }
+}
+
+#endif // _XMP_SUPPORT_
+
+class KExiv2KeywordTreePrivate
+{
+public:
+
+    struct Node
+    {
+        int        parent = -1;
+        QString    name;
+        QList<int> children;
+    };
+
+    typedef QPair<int, QString> ChildKey;
+
+public:
+
+    bool isValid(int node) const
+    {
+        return (node >= 0 && node < (int)nodes.size());
+    }
+
+    QList<int>& childrenOf(int node)
+    {
+        return ((node == -1) ? topLevel : nodes[node].children);
+    }
+
+    /** Returns the node of a path read from the metadata. The paths are repeated in many
+     *  images: they are split only the first time, then found in the cache.
+     */
+    int cachedInsert(KExiv2KeywordTree& tree, QHash<QString, int>& cache, const QString& path, QChar separator)
+    {
+        QHash<QString, int>::const_iterator it = cache.constFind(path);
+
+        if (it != cache.constEnd())
+            return it.value();
+
+        const int node = tree.insert(path, separator);
+        cache.insert(path, node);
+
+        return node;
+    }
+
+    /** The cached paths are no longer valid once a node has been renamed or moved.
+     */
+    void clearCaches()
+    {
+        for (QHash<QString, int>& cache : pathCaches)
+        {
+            cache.clear();
+        }
+    }
+
+public:
+
+    std::vector<Node>       nodes;
+    QList<int>              topLevel;
+
+    /// The node of each name under its parent, -1 for the top level nodes.
+    QHash<ChildKey, int>    index;
+
+    /// The nodes of the raw paths already read, by tag.
+    QHash<QString, int>     pathCaches[KeywordTags];
+};
+
+KExiv2KeywordTree::KExiv2KeywordTree()
+    : d(new KExiv2KeywordTreePrivate)
+{
+}
+
+KExiv2KeywordTree::~KExiv2KeywordTree() = default;
+
+void KExiv2KeywordTree::clear()
+{
+    d->nodes.clear();
+    d->topLevel.clear();
+    d->index.clear();
+    d->clearCaches();
+}
+
+int KExiv2KeywordTree::count() const
+{
+    return (int)d->nodes.size();
+}
+
+int KExiv2KeywordTree::find(const QString& path, QChar separator) const
+{
+    int node = -1;
+
+    for (const QString& name : splitPath(path, separator))
+    {
+        node = d->index.value(KExiv2KeywordTreePrivate::ChildKey(node, name), -2);
+
+        if (node == -2)
+            return -1;
+    }
+
+    return node;
+}
+
+int KExiv2KeywordTree::insert(const QString& path, QChar separator)
+{
+    int node = -1;
+
+    for (const QString& name : splitPath(path, separator))
+    {
+        node = child(node, name);
+    }
+
+    return node;
+}
+
+int KExiv2KeywordTree::child(int parent, const QString& name)
+{
+    if ((parent != -1 && !d->isValid(parent)) || name.isEmpty())
+        return -1;
+
+    const KExiv2KeywordTreePrivate::ChildKey key(parent, name);
+    QHash<KExiv2KeywordTreePrivate::ChildKey, int>::const_iterator it = d->index.constFind(key);
+
+    if (it != d->index.constEnd())
+        return it.value();
+
+    const int node = (int)d->nodes.size();
+
+    KExiv2KeywordTreePrivate::Node item;
+    item.parent = parent;
+    item.name   = name;
+    d->nodes.push_back(item);
+
+    d->childrenOf(parent) << node;
+    d->index.insert(key, node);
+
+    return node;
+}
+
+int KExiv2KeywordTree::parent(int node) const
+{
+    return (d->isValid(node) ? d->nodes[node].parent : -1);
+}
+
+QList<int> KExiv2KeywordTree::children(int node) const
+{
+    if (node == -1)
+        return d->topLevel;
+
+    return (d->isValid(node) ? d->nodes[node].children : QList<int>());
+}
+
+QString KExiv2KeywordTree::name(int node) const
+{
+    return (d->isValid(node) ? d->nodes[node].name : QString());
+}
+
+QString KExiv2KeywordTree::path(int node, QChar separator) const
+{
+    if (!d->isValid(node))
+        return QString();
+
+    QStringList names;
+
+    for ( ; node != -1 ; node = d->nodes[node].parent)
+    {
+        names.prepend(escapedName(d->nodes[node].name, separator));
+    }
+
+    return names.join(separator);
+}
+
+bool KExiv2KeywordTree::isDescendant(int node, int ancestor) const
+{
+    if (!d->isValid(node) || !d->isValid(ancestor))
+        return false;
+
+    for ( ; node != -1 ; node = d->nodes[node].parent)
+    {
+        if (node == ancestor)
+            return true;
+    }
+
+    return false;
+}
+
+bool KExiv2KeywordTree::contains(const QList<int>& keywords, int node) const
+{
+    return std::any_of(keywords.constBegin(), keywords.constEnd(),
+                       [this, node](int keyword) { return isDescendant(keyword, node); });
+}
+
+bool KExiv2KeywordTree::rename(int node, const QString& name)
+{
+    if (!d->isValid(node) || name.isEmpty())
+        return false;
+
+    KExiv2KeywordTreePrivate::Node& item = d->nodes[node];
+
+    if (item.name == name)
+        return true;
+
+    const KExiv2KeywordTreePrivate::ChildKey key(item.parent, name);
+
+    if (d->index.contains(key))
+        return false;
+
+    d->index.remove(KExiv2KeywordTreePrivate::ChildKey(item.parent, item.name));
+    d->index.insert(key, node);
+    item.name = name;
+    d->clearCaches();
+
+    return true;
+}
+
+bool KExiv2KeywordTree::move(int node, int newParent)
+{
+    if (!d->isValid(node) || (newParent != -1 && !d->isValid(newParent)))
+        return false;
+
+    KExiv2KeywordTreePrivate::Node& item = d->nodes[node];
+
+    if (item.parent == newParent)
+        return true;
+
+    const KExiv2KeywordTreePrivate::ChildKey key(newParent, item.name);
+
+    if (isDescendant(newParent, node) || d->index.contains(key))
+        return false;
+
+    d->index.remove(KExiv2KeywordTreePrivate::ChildKey(item.parent, item.name));
+    d->childrenOf(item.parent).removeOne(node);
+
+    d->index.insert(key, node);
+    d->childrenOf(newParent) << node;
+    item.parent = newParent;
+    d->clearCaches();
+
+    return true;
+}
+
+QList<int> KExiv2KeywordTree::read(const KExiv2& metadata, QList<int>* names)
+{
+    QList<int> keywords;
+
+    if (names)
+        names->clear();
+
+#ifdef _XMP_SUPPORT_
+
+    try
+    {
+        QSet<int>       found;
+        QList<QString>  flat;
+
+        // One walk over the XMP metadata for the three tags.
+
+        for (const Exiv2::Xmpdatum& datum : std::as_const(*metadata.d).xmpMetadata())
+        {
+            const std::string key = datum.key();
+            int tag               = LightroomTag;
+
+            while (tag < KeywordTags && key != s_keywordKeys[tag])
+            {
+                ++tag;
+            }
+
+            const Exiv2::XmpArrayValue* const array = (tag < KeywordTags)
+                                                      ? dynamic_cast<const Exiv2::XmpArrayValue*>(&datum.value())
+                                                      : nullptr;
+
+            if (!array)
+                continue;
+
+            const size_t count = static_cast<size_t>(array->count());
+
+            for (size_t i = 0 ; i < count ; ++i)
+            {
+                const std::string item = array->toString(i);
+                const QString entry    = QString::fromUtf8(item.data(), item.size());
+
+                if (tag == SubjectTag)
+                {
+                    flat << entry;
+                    continue;
+                }
+
+                const int node = d->cachedInsert(*this, d->pathCaches[tag], entry,
+                                                 (tag == LightroomTag) ? s_lightroomSeparator
+                                                                       : s_digiKamSeparator);
+
+                if (node == -1)
+                {
+                    qCDebug(LIBKEXIV2_LOG) << "Keyword" << entry << "cannot be stored in the keyword tree";
+                }
+                else if (!found.contains(node))
+                {
+                    found.insert(node);
+                    keywords << node;
+                }
+            }
+        }
+
+        if (flat.isEmpty())
+            return keywords;
+
+        // The entries of dc:subject naming a keyword are written back with it. The ones naming
+        // another node of its path, as the parents added by Lightroom, are returned apart.
+
+        QSet<QString>       leaves;
+        QHash<QString, int> parents;
+
+        for (int node : std::as_const(keywords))
+        {
+            leaves.insert(d->nodes[node].name);
+
+            for (node = d->nodes[node].parent ; node != -1 ; node = d->nodes[node].parent)
+            {
+                parents.insert(d->nodes[node].name, node);
+            }
+        }
+
+        for (const QString& entry : std::as_const(flat))
+        {
+            if (leaves.contains(entry))
+                continue;
+
+            QHash<QString, int>::const_iterator it = parents.constFind(entry);
+
+            if (it != parents.constEnd())
+            {
+                if (names && !names->contains(it.value()))
+                    *names << it.value();
+
+                continue;
+            }
+
+            const int node = child(-1, entry);
+
+            if (node == -1)
+            {
+                qCDebug(LIBKEXIV2_LOG) << "Keyword" << entry << "cannot be stored in the keyword tree";
+                continue;
+            }
+
+            if (!found.contains(node))
+            {
+                found.insert(node);
+                keywords << node;
+            }
+        }
+    }
+    catch( Exiv2::Error& e )
+    {
+        KExiv2Private::printExiv2ExceptionError(QString::fromLatin1("Cannot read keywords using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+#else
+
+    Q_UNUSED(metadata);
+    Q_UNUSED(names);
+
+#endif // _XMP_SUPPORT_
+
+    return keywords;
+}
+
+bool KExiv2KeywordTree::write(const KExiv2& metadata, const QList<int>& keywords, const QList<int>& names,
+                              bool setProgramName) const
+{
+#ifdef _XMP_SUPPORT_
+
+    if (!metadata.applyProgramId(setProgramName))
+        return false;
+
+    static const Exiv2::TypeId types[KeywordTags] = { Exiv2::xmpBag, Exiv2::xmpSeq, Exiv2::xmpBag };
+
+    std::vector<std::string> values[KeywordTags];
+    QSet<int>                written;
+    QSet<QString>            subjects;
+
+    for (int node : keywords)
+    {
+        if (!d->isValid(node) || written.contains(node))
+            continue;
+
+        written.insert(node);
+        values[LightroomTag].push_back(path(node, s_lightroomSeparator).toUtf8().toStdString());
+        values[DigiKamTag].push_back(path(node, s_digiKamSeparator).toUtf8().toStdString());
+
+        const QString& name = d->nodes[node].name;
+
+        if (!subjects.contains(name))
+        {
+            subjects.insert(name);
+            values[SubjectTag].push_back(name.toUtf8().toStdString());
+        }
+    }
+
+    for (int node : names)
+    {
+        if (!d->isValid(node) || subjects.contains(d->nodes[node].name))
+            continue;
+
+        subjects.insert(d->nodes[node].name);
+        values[SubjectTag].push_back(d->nodes[node].name.toUtf8().toStdString());
+    }
+
+    try
+    {
+        // Find the three tags in one walk, and compare them without detaching the metadata.
+
+        const Exiv2::XmpData& constXmp = std::as_const(*metadata.d).xmpMetadata();
+        long positions[KeywordTags]    = { -1, -1, -1 };
+        bool changed[KeywordTags]      = { false, false, false };
+        bool anyChange                 = false;
+
+        for (Exiv2::XmpData::const_iterator it = constXmp.begin() ; it != constXmp.end() ; ++it)
+        {
+            const std::string key = it->key();
+
+            for (int tag = LightroomTag ; tag < KeywordTags ; ++tag)
+            {
+                if (positions[tag] == -1 && key == s_keywordKeys[tag])
+                {
+                    positions[tag] = it - constXmp.begin();
+                    break;
+                }
+            }
+        }
+
+        for (int tag = LightroomTag ; tag < KeywordTags ; ++tag)
+        {
+            if (positions[tag] == -1)
+            {
+                changed[tag] = !values[tag].empty();
+            }
+            else
+            {
+                const Exiv2::Xmpdatum& datum            = constXmp.begin()[positions[tag]];
+                const Exiv2::XmpArrayValue* const array = dynamic_cast<const Exiv2::XmpArrayValue*>(&datum.value());
+                changed[tag]                            = (!array || datum.typeId() != types[tag] ||
+                                                           !hasItems(*array, values[tag]));
+            }
+
+            anyChange |= changed[tag];
+        }
+
+        if (!anyChange)
+            return true;
+
+        Exiv2::XmpData& xmp = metadata.d->xmpMetadata();
+        std::vector<long> erased;
+
+        // Replace the values in place first, erasing shifts the positions after.
+
+        for (int tag = LightroomTag ; tag < KeywordTags ; ++tag)
+        {
+            if (!changed[tag] || positions[tag] == -1)
+                continue;
+
+            if (values[tag].empty())
+            {
+                erased.push_back(positions[tag]);
+                continue;
+            }
+
+            Exiv2::XmpArrayValue value(types[tag]);
+            appendItems(value, values[tag]);
+            xmp.begin()[positions[tag]].setValue(&value);
+        }
+
+        std::sort(erased.begin(), erased.end(), std::greater<long>());
+
+        for (long pos : erased)
+        {
+            xmp.erase(xmp.begin() + pos);
+        }
+
+        for (int tag = LightroomTag ; tag < KeywordTags ; ++tag)
+        {
+            if (!changed[tag] || positions[tag] != -1)
+                continue;
+
+            Exiv2::XmpArrayValue value(types[tag]);
+            appendItems(value, values[tag]);
+            xmp.add(Exiv2::XmpKey(s_keywordKeys[tag]), &value);
+        }
+
+        return true;
+    }
+    catch( Exiv2::Error& e )
+    {
+        KExiv2Private::printExiv2ExceptionError(QString::fromLatin1("Cannot write keywords using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+#else
+
+    Q_UNUSED(metadata);
+    Q_UNUSED(keywords);
+    Q_UNUSED(names);
+    Q_UNUSED(setProgramName);
+
+#endif // _XMP_SUPPORT_
+
+    return false;
+}
+
+} // namespace KExiv2Iface
@@ -0,0 +1,186 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KEXIV2KEYWORDTREE_H
+#define KEXIV2KEYWORDTREE_H
+
+// Std
+
+#include <memory>
+
+// Qt includes
+
+#include <QChar>
+#include <QList>
+#include <QString>
+
+// Local includes
+
+#include "libkexiv2_export.h"
+
+namespace KExiv2Iface
+{
+
+class KExiv2;
+
+/*!
+ * \class KExiv2Iface::KExiv2KeywordTree
+ * \inmodule KExiv2
+ * \inheaderfile KExiv2/KExiv2KeywordTree
+ *
+ * \brief Tree of hierarchical keywords shared by a collection of images.
+ *
+ * Each keyword is a node of the tree, identified by an integer which stays valid for the
+ * lifetime of the tree. The paths read from the images are parsed once: the images sharing
+ * a keyword share its node, and the keywords of an image are the list of their node ids.
+ *
+ * Renaming or moving a node changes the path of the whole subtree at once. The new paths
+ * are written back to each image with write(), which sets Xmp.lr.hierarchicalSubject,
+ * Xmp.digiKam.TagsList and Xmp.dc.subject in a single walk of the XMP metadata.
+ *
+ * A name can hold any character. In a path, a separator or a backslash which is part of
+ * a name is escaped with a backslash: "Music/AC\\/DC" is the node "AC/DC" under "Music".
+ *
+ * A typical use, to rename a keyword in a collection:
+ *
+ * \code
+ * KExiv2KeywordTree tree;
+ * QList<QList<int> > keywords;
+ * QList<QList<int> > names;
+ *
+ * for (KExiv2* const meta : images)
+ * {
+ *     names << QList<int>();
+ *     keywords << tree.read(*meta, &names.last());
+ * }
+ *
+ * const int node = tree.find(QLatin1String("Places/Paris"));
+ * tree.rename(node, QLatin1String("Paris, France"));
+ *
+ * for (int i = 0 ; i < images.size() ; ++i)
+ *     if (tree.contains(keywords.at(i), node))
+ *         tree.write(*images.at(i), keywords.at(i), names.at(i));
+ * \endcode
+ */
+class LIBKEXIV2_EXPORT KExiv2KeywordTree
+{
+public:
+
+    /*!
+     * Constructs an empty tree.
+     */
+    KExiv2KeywordTree();
+    /*!
+     */
+    ~KExiv2KeywordTree();
+
+    /*!
+     * Removes all nodes. The node ids returned before are no longer valid.
+     */
+    void clear();
+
+    /*!
+     * Returns the number of nodes in the tree.
+     */
+    int count() const;
+
+    /*!
+     * Returns the node of \a path, where the names are separated by \a separator,
+     * or -1 if the tree has no such node. Empty names are skipped, and a backslash
+     * escapes a separator or a backslash inside a name.
+     */
+    int find(const QString& path, QChar separator = QLatin1Char('/')) const;
+
+    /*!
+     * Returns the node of \a path, where the names are separated by \a separator and
+     * escaped as in find(). The missing nodes are created. Returns -1 if the path has no name.
+     */
+    int insert(const QString& path, QChar separator = QLatin1Char('/'));
+
+    /*!
+     * Returns the child of \a parent called \a name, created if missing, or -1 if \a name
+     * is empty. The \a name is not a path: it can hold separators. A \a parent of -1 is the
+     * root of the tree.
+     */
+    int child(int parent, const QString& name);
+
+    /*!
+     * Returns the parent of \a node, or -1 for a top level node.
+     */
+    int parent(int node) const;
+
+    /*!
+     * Returns the children of \a node, or the top level nodes if \a node is -1.
+     */
+    QList<int> children(int node) const;
+
+    /*!
+     * Returns the name of \a node.
+     */
+    QString name(int node) const;
+
+    /*!
+     * Returns the path of \a node, where the names are separated by \a separator.
+     * The separators and backslashes of the names are escaped as read by find().
+     */
+    QString path(int node, QChar separator = QLatin1Char('/')) const;
+
+    /*!
+     * Returns \c true if \a node is \a ancestor or one of its descendants.
+     */
+    bool isDescendant(int node, int ancestor) const;
+
+    /*!
+     * Returns \c true if one of \a keywords is \a node or one of its descendants:
+     * the image with these keywords needs to be written after a change of \a node.
+     */
+    bool contains(const QList<int>& keywords, int node) const;
+
+    /*!
+     * Renames \a node to \a name. The paths of all its descendants change with it.
+     * Returns \c false if \a name is empty or already used by a sibling.
+     */
+    bool rename(int node, const QString& name);
+
+    /*!
+     * Moves \a node with its subtree under \a newParent, or to the top level if
+     * \a newParent is -1. Returns \c false if \a newParent is inside the subtree,
+     * or already has a child with the same name.
+     */
+    bool move(int node, int newParent);
+
+    /*!
+     * Reads the keywords of \a metadata and returns their nodes, created if missing.
+     *
+     * The paths are taken from Xmp.lr.hierarchicalSubject, separated by '|', and from
+     * Xmp.digiKam.TagsList, separated by '/'. The entries of Xmp.dc.subject which name
+     * a keyword are written back with it. The ones naming one of its parents, as added by
+     * Lightroom, are returned in \a names if it is not null: pass them to write() to keep
+     * them. The other entries of Xmp.dc.subject are flat keywords, returned as top level
+     * nodes.
+     */
+    QList<int> read(const KExiv2& metadata, QList<int>* names = nullptr);
+
+    /*!
+     * Writes the \a keywords to \a metadata: their paths to Xmp.lr.hierarchicalSubject and
+     * Xmp.digiKam.TagsList, and their names, followed by the ones of the \a names nodes
+     * returned by read(), to Xmp.dc.subject. The tags are removed if they have no entry.
+     * Tags already holding these values are not rewritten.
+     *
+     * If \a setProgramName is \c true, the program name is set in the metadata.
+     * Returns \c false if the metadata cannot be written.
+     */
+    bool write(const KExiv2& metadata, const QList<int>& keywords, const QList<int>& names = QList<int>(),
+               bool setProgramName = true) const;
+
+private:
+
+    std::unique_ptr<class KExiv2KeywordTreePrivate> const d;
+};
+
+} // namespace KExiv2Iface
+
+#endif // KEXIV2KEYWORDTREE_H
@@ -5,6 +5,10 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
+// C++ includes
+
+#include <map>
+
 // Local includes
 
 #include "kexiv2previews.h"
@@ -21,7 +25,8 @@ public:
 
     KExiv2PreviewsPrivate()
     {
-        manager = nullptr;
+        manager    = nullptr;
+        enumerated = false;
     }
 
     ~KExiv2PreviewsPrivate()
@@ -36,23 +41,91 @@ public:
 #endif
     {
 #if EXIV2_TEST_VERSION(0,28,0)
-        image                              = std::move(image_);
+        image        = std::move(image_);
 #else
-        image                              = image_;
+        image        = image_;
 #endif
 
         image->readMetadata();
 
-        manager                            = new Exiv2::PreviewManager(*image);
-        Exiv2::PreviewPropertiesList props = manager->getPreviewProperties();
+        originalSize = QSize(image->pixelWidth(), image->pixelHeight());
+    }
+
+    /** Same as load(), with the metadata already parsed by \a metadata instead of parsing
+     *  the file again. The XMP metadata are set too: Exiv2 also reads the previews of
+     *  Xmp.xmp.Thumbnails.
+     */
+#if EXIV2_TEST_VERSION(0,28,0)
+    void load(Exiv2::Image::UniquePtr image_, const KExiv2Private& metadata)
+#else
+    void load(Exiv2::Image::AutoPtr image_, const KExiv2Private& metadata)
+#endif
+    {
+#if EXIV2_TEST_VERSION(0,28,0)
+        image        = std::move(image_);
+#else
+        image        = image_;
+#endif
+
+        image->setExifData(metadata.exifMetadata());
+        image->setIptcData(metadata.iptcMetadata());
+#ifdef _XMP_SUPPORT_
+        image->setXmpData(metadata.xmpMetadata());
+#endif
 
-        // reverse order of list, which is smallest-first
-        Exiv2::PreviewPropertiesList::reverse_iterator it;
+        originalSize = metadata.pixelSize;
+    }
 
-        for (it = props.rbegin() ; it != props.rend() ; ++it)
+    /** Returns true if previews of the format are stored outside of the Exif and XMP
+     *  metadata, and can only be found by a full parsing of the file.
+     */
+    static bool hasNativePreviews(const std::string& mimeType)
+    {
+        return (mimeType == "image/x-photoshop"       ||
+                mimeType == "application/postscript"  ||
+                mimeType == "image/x-canon-cr3"       ||
+                mimeType == "image/heif"              ||
+                mimeType == "image/heic"              ||
+                mimeType == "image/avif"              ||
+                mimeType == "image/jxl");
+    }
+
+    /** Creates the preview manager and lists the previews on first use.
+     *  Returns false if there are no previews.
+     */
+    bool enumerate()
+    {
+        if (!enumerated)
         {
-            properties << *it;
+            enumerated = true;
+
+            if (!image.get())
+                return false;
+
+            try
+            {
+                manager    = new Exiv2::PreviewManager(*image);
+                properties = manager->getPreviewProperties();
+            }
+            catch( Exiv2::Error& e )
+            {
+                KExiv2Private::printExiv2ExceptionError(QString::fromLatin1("Cannot list previews using Exiv2 "), e);
+            }
+            catch(...)
+            {
+                qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+            }
         }
+
+        return !properties.empty();
+    }
+
+    /** Returns the properties of the preview at \a index, largest first.
+     *  Exiv2 lists the previews smallest first.
+     */
+    const Exiv2::PreviewProperties& property(int index) const
+    {
+        return properties[properties.size() - 1 - index];
     }
 
 public:
@@ -63,7 +136,12 @@ public:
     Exiv2::Image::AutoPtr           image;
 #endif
     Exiv2::PreviewManager*          manager;
-    QList<Exiv2::PreviewProperties> properties;
+    Exiv2::PreviewPropertiesList    properties;
+    bool                            enumerated;
+    QSize                           originalSize;
+
+    /// The previews loaded by dataView(), owning the viewed data.
+    std::map<int, std::unique_ptr<Exiv2::PreviewImage> > images;
 };
 
 KExiv2Previews::KExiv2Previews(const QString& filePath)
@@ -112,19 +190,61 @@ KExiv2Previews::KExiv2Previews(const QByteArray& imgData)
     }
 }
 
+KExiv2Previews::KExiv2Previews(const KExiv2& metadata)
+    : d(new KExiv2PreviewsPrivate)
+{
+    const KExiv2Private& priv = *metadata.d;
+
+    if (priv.filePath.isEmpty())
+    {
+        qCDebug(LIBKEXIV2_LOG) << "Metadata not loaded from a file: no previews to scan";
+        return;
+    }
+
+    try
+    {
+#if EXIV2_TEST_VERSION(0,28,0)
+        Exiv2::Image::UniquePtr image = Exiv2::ImageFactory::open((const char*)(QFile::encodeName(priv.filePath).constData()));
+#else
+        Exiv2::Image::AutoPtr image = Exiv2::ImageFactory::open((const char*)(QFile::encodeName(priv.filePath).constData()));
+#endif
+
+        // The metadata of a sidecar do not describe the previews of the file,
+        // and some formats store their previews outside of the Exif and XMP metadata.
+        const bool reuse = !priv.loadedFromSidecar && !KExiv2PreviewsPrivate::hasNativePreviews(image->mimeType());
+
+#if EXIV2_TEST_VERSION(0,28,0)
+        if (reuse)
+            d->load(std::move(image), priv);
+        else
+            d->load(std::move(image));
+#else
+        if (reuse)
+            d->load(image, priv);
+        else
+            d->load(image);
+#endif
+    }
+    catch( Exiv2::Error& e )
+    {
+        KExiv2Private::printExiv2ExceptionError(QString::fromLatin1("Cannot load metadata using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+}
+
 KExiv2Previews::~KExiv2Previews() = default;
 
 bool KExiv2Previews::isEmpty()
 {
-    return d->properties.isEmpty();
+    return !d->enumerate();
 }
 
 QSize KExiv2Previews::originalSize() const
 {
-    if (d->image.get())
-        return QSize(d->image->pixelWidth(), d->image->pixelHeight());
-
-    return QSize();
+    return d->originalSize;
 }
 
 QString KExiv2Previews::originalMimeType() const
@@ -137,42 +257,44 @@ QString KExiv2Previews::originalMimeType() const
 
 int KExiv2Previews::count()
 {
-    return d->properties.size();
+    d->enumerate();
+
+    return (int)d->properties.size();
 }
 
 int KExiv2Previews::dataSize(int index)
 {
     if (index < 0 || index >= size()) return 0;
 
-    return d->properties[index].size_;
+    return d->property(index).size_;
 }
 
 int KExiv2Previews::width(int index)
 {
     if (index < 0 || index >= size()) return 0;
 
-    return d->properties[index].width_;
+    return d->property(index).width_;
 }
 
 int KExiv2Previews::height(int index)
 {
     if (index < 0 || index >= size()) return 0;
 
-    return d->properties[index].height_;
+    return d->property(index).height_;
 }
 
 QString KExiv2Previews::mimeType(int index)
 {
     if (index < 0 || index >= size()) return QString();
 
-    return QString::fromLatin1(d->properties[index].mimeType_.c_str());
+    return QString::fromLatin1(d->property(index).mimeType_.c_str());
 }
 
 QString KExiv2Previews::fileExtension(int index)
 {
     if (index < 0 || index >= size()) return QString();
 
-    return QString::fromLatin1(d->properties[index].extension_.c_str());
+    return QString::fromLatin1(d->property(index).extension_.c_str());
 }
 
 QByteArray KExiv2Previews::data(int index)
@@ -182,9 +304,15 @@ QByteArray KExiv2Previews::data(int index)
     qCDebug(LIBKEXIV2_LOG) << "index: "         << index;
     qCDebug(LIBKEXIV2_LOG) << "d->properties: " << count();
 
+    // Reuse the preview if already loaded by dataView().
+    std::map<int, std::unique_ptr<Exiv2::PreviewImage> >::const_iterator it = d->images.find(index);
+
+    if (it != d->images.end())
+        return QByteArray((const char*)it->second->pData(), it->second->size());
+
     try
     {
-        Exiv2::PreviewImage image = d->manager->getPreviewImage(d->properties[index]);
+        Exiv2::PreviewImage image = d->manager->getPreviewImage(d->property(index));
         return QByteArray((const char*)image.pData(), image.size());
     }
     catch( Exiv2::Error& e )
@@ -199,15 +327,109 @@ QByteArray KExiv2Previews::data(int index)
     }
 }
 
+QByteArrayView KExiv2Previews::dataView(int index)
+{
+    if (index < 0 || index >= size()) return QByteArrayView();
+
+    std::unique_ptr<Exiv2::PreviewImage>& image = d->images[index];
+
+    if (!image)
+    {
+        try
+        {
+            image.reset(new Exiv2::PreviewImage(d->manager->getPreviewImage(d->property(index))));
+        }
+        catch( Exiv2::Error& e )
+        {
+            KExiv2Private::printExiv2ExceptionError(QString::fromLatin1("Cannot load metadata using Exiv2 "), e);
+            d->images.erase(index);
+            return QByteArrayView();
+        }
+        catch(...)
+        {
+            qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+            d->images.erase(index);
+            return QByteArrayView();
+        }
+    }
+
+    return QByteArrayView((const char*)image->pData(), image->size());
+}
+
 QImage KExiv2Previews::image(int index)
 {
-    QByteArray previewData = data(index);
-    QImage     image;
+    return image(index, QSize());
+}
+
+QImage KExiv2Previews::image(int index, const QSize& targetSize)
+{
+    if (index < 0 || index >= size()) return QImage();
+
+    // Pass the format to the image reader, instead of letting it probe the data.
+    QByteArray format(d->property(index).extension_.c_str());
+
+    if (format.startsWith('.'))
+        format.remove(0, 1);
+
+    // Decode from the Exiv2 buffer, without a copy.
+    std::map<int, std::unique_ptr<Exiv2::PreviewImage> >::const_iterator it = d->images.find(index);
+
+    if (it != d->images.end())
+    {
+        return KExiv2Private::loadScaledImage(QByteArray::fromRawData((const char*)it->second->pData(), it->second->size()),
+                                              targetSize, format);
+    }
+
+    try
+    {
+        Exiv2::PreviewImage image = d->manager->getPreviewImage(d->property(index));
 
-    if (!image.loadFromData(previewData))
-        return QImage();
+        return KExiv2Private::loadScaledImage(QByteArray::fromRawData((const char*)image.pData(), image.size()),
+                                              targetSize, format);
+    }
+    catch( Exiv2::Error& e )
+    {
+        KExiv2Private::printExiv2ExceptionError(QString::fromLatin1("Cannot load metadata using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+    return QImage();
+}
+
+int KExiv2Previews::indexForSize(const QSize& targetSize)
+{
+    if (isEmpty()) return -1;
+
+    // Previews are sorted largest first: the last large enough one is the smallest.
+    int index = 0;
+
+    for (int i = 1 ; i < size() ; ++i)
+    {
+        if ((int)d->property(i).width_  < targetSize.width() ||
+            (int)d->property(i).height_ < targetSize.height())
+        {
+            continue;
+        }
+
+        index = i;
+    }
+
+    return index;
+}
+
+int KExiv2Previews::indexForMaximumPixels(qint64 maxPixels)
+{
+    // Previews are sorted largest first: the first small enough one is the largest.
+    for (int i = 0 ; i < size() ; ++i)
+    {
+        if ((qint64)d->property(i).width_ * d->property(i).height_ <= maxPixels)
+            return i;
+    }
 
-    return image;
+    return -1;
 }
 
 } // namespace KExiv2Iface
@@ -15,6 +15,7 @@
 // Qt includes
 
 #include <QByteArray>
+#include <QByteArrayView>
 #include <QSize>
 #include <QString>
 
@@ -27,10 +28,15 @@ class QImage;
 namespace KExiv2Iface
 {
 
+class KExiv2;
+
 /*!
  * \class KExiv2Iface::KExiv2Previews
  * \inmodule KExiv2
  * \inheaderfile KExiv2/KExiv2Previews
+ *
+ * The embedded previews are listed on first use, not when the image is opened:
+ * originalSize() and originalMimeType() do not pay for the scan of the previews.
  */
 class LIBKEXIV2_EXPORT KExiv2Previews
 {
@@ -45,6 +51,17 @@ public:
      * Open the given image data and scan the image for embedded preview images.
      */
     KExiv2Previews(const QByteArray& imgData);
+
+    /*!
+     * Scan the file the \a metadata were loaded from for embedded preview images.
+     * The Exif, IPTC and XMP metadata already parsed by \a metadata are reused instead
+     * of parsing the file again, except when they come from a sidecar file or for formats
+     * storing their previews outside of the Exif and XMP metadata.
+     *
+     * The metadata must not have been changed since loaded, and must have been
+     * loaded from a file: there are no previews for metadata loaded from data.
+     */
+    KExiv2Previews(const KExiv2& metadata);
     /*!
      */
     ~KExiv2Previews();
@@ -100,6 +117,13 @@ public:
      */
     QByteArray data(int index = 0);
 
+    /*!
+     * Returns a view on the image data of the specified embedded preview image,
+     * without copying it from the Exiv2 buffer. The preview is kept in memory
+     * and the view stays valid as long as this object exists.
+     */
+    QByteArrayView dataView(int index = 0);
+
     /*!
      * Loads the data of the specified preview and creates a QImage
      * from this data.
@@ -108,6 +132,31 @@ public:
      */
     QImage image(int index = 0);
 
+    /*!
+     * Loads the data of the specified preview and creates a QImage scaled down
+     * to fit in \a targetSize, keeping the aspect ratio. The scaling is done while
+     * decoding, which is much faster than loading the full image and scaling it
+     * afterwards. The preview is never scaled up.
+     *
+     * Returns a null QImage if the loading failed.
+     *
+     * \sa indexForSize()
+     */
+    QImage image(int index, const QSize& targetSize);
+
+    /*!
+     * Returns the index of the smallest preview which is at least as wide and
+     * as high as \a targetSize, or the index of the largest preview if none is
+     * large enough. Returns -1 if there are no previews.
+     */
+    int        indexForSize(const QSize& targetSize);
+
+    /*!
+     * Returns the index of the largest preview with at most \a maxPixels pixels
+     * (width * height), or -1 if there is none.
+     */
+    int        indexForMaximumPixels(qint64 maxPixels);
+
 private:
     std::unique_ptr<class KExiv2PreviewsPrivate> const d;
 };
@@ -0,0 +1,288 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// C++ includes
+
+#include <algorithm>
+#include <memory>
+
+// Qt includes
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QVector>
+
+// Local includes
+
+#include "kexiv2_p.h"
+#include "kexiv2.h"
+#include "libkexiv2_debug.h"
+
+namespace KExiv2Iface
+{
+
+/**
+ * Search index over the tags catalogue supported by Exiv2.
+ *
+ * Prefix queries are resolved with a binary search in a sorted table of the case folded keys,
+ * names and titles. Substring queries use the posting lists of bigrams and trigrams to select
+ * a small set of candidates which are checked afterwards.
+ */
+class KExiv2TagsIndex
+{
+public:
+
+    explicit KExiv2TagsIndex(const KExiv2& meta);
+
+    KExiv2::TagsMap search(const QString& text, KExiv2::TagsSearchMode mode, int maxResults) const;
+
+private:
+
+    struct Entry
+    {
+        QString     key;
+        QStringList values;
+        QString     fields[3];      // Case folded key, name and title.
+    };
+
+    struct Term
+    {
+        QString text;
+        int     entry;
+    };
+
+    /** Pack 2 or 3 UTF-16 code units to a hash key. Bigrams use the bit 48 to never clash with trigrams.
+     */
+    static quint64 gram(const QChar* const c, int size);
+
+    bool matches(const Entry& entry, const QString& folded) const;
+
+private:
+
+    QVector<Entry>                entries;
+    QVector<Term>                 terms;
+    QHash<quint64, QVector<int> > grams;
+};
+
+KExiv2TagsIndex::KExiv2TagsIndex(const KExiv2& meta)
+{
+    KExiv2::TagsMap tagsMap = meta.getStdExifTagsList();
+    tagsMap.insert(meta.getMakernoteTagsList());
+    tagsMap.insert(meta.getIptcTagsList());
+    tagsMap.insert(meta.getXmpTagsList());
+
+    entries.reserve(tagsMap.size());
+    terms.reserve(tagsMap.size() * 3);
+
+    QSet<quint64> entryGrams;
+
+    for (KExiv2::TagsMap::const_iterator it = tagsMap.constBegin(); it != tagsMap.constEnd(); ++it)
+    {
+        const int index = entries.size();
+        Entry entry;
+        entry.key       = it.key();
+        entry.values    = it.value();
+        entry.fields[0] = entry.key.toCaseFolded();
+        entry.fields[1] = entry.values.value(0).toCaseFolded();
+        entry.fields[2] = entry.values.value(1).toCaseFolded();
+
+        entryGrams.clear();
+
+        for (int f = 0 ; f < 3 ; ++f)
+        {
+            const QString& field = entry.fields[f];
+
+            if (field.isEmpty())
+            {
+                continue;
+            }
+
+            Term term;
+            term.text  = field;
+            term.entry = index;
+            terms.append(term);
+
+            for (int i = 0 ; i + 2 <= field.size() ; ++i)
+            {
+                entryGrams.insert(gram(field.constData() + i, 2));
+
+                if (i + 3 <= field.size())
+                {
+                    entryGrams.insert(gram(field.constData() + i, 3));
+                }
+            }
+        }
+
+        // Entries are visited in order, so all posting lists stay sorted without duplicates.
+
+        for (QSet<quint64>::const_iterator g = entryGrams.constBegin(); g != entryGrams.constEnd(); ++g)
+        {
+            grams[*g].append(index);
+        }
+
+        entries.append(entry);
+    }
+
+    std::sort(terms.begin(), terms.end(),
+              [](const Term& a, const Term& b)
+              {
+                  return a.text < b.text;
+              });
+
+    qCDebug(LIBKEXIV2_LOG) << "Tags catalogue index built with" << entries.size() << "tags";
+}
+
+quint64 KExiv2TagsIndex::gram(const QChar* const c, int size)
+{
+    if (size == 2)
+    {
+        return (Q_UINT64_C(1) << 48) | (quint64(c[0].unicode()) << 16) | quint64(c[1].unicode());
+    }
+
+    return (quint64(c[0].unicode()) << 32) | (quint64(c[1].unicode()) << 16) | quint64(c[2].unicode());
+}
+
+bool KExiv2TagsIndex::matches(const Entry& entry, const QString& folded) const
+{
+    return (entry.fields[0].contains(folded) ||
+            entry.fields[1].contains(folded) ||
+            entry.fields[2].contains(folded));
+}
+
+KExiv2::TagsMap KExiv2TagsIndex::search(const QString& text, KExiv2::TagsSearchMode mode, int maxResults) const
+{
+    KExiv2::TagsMap result;
+    const QString folded = text.toCaseFolded();
+
+    if (folded.isEmpty())
+    {
+        return result;
+    }
+
+    if (mode == KExiv2::PREFIX_SEARCH)
+    {
+        QVector<Term>::const_iterator it = std::lower_bound(terms.constBegin(), terms.constEnd(), folded,
+                                                            [](const Term& term, const QString& value)
+                                                            {
+                                                                return term.text < value;
+                                                            });
+
+        for ( ; it != terms.constEnd() && it->text.startsWith(folded) ; ++it)
+        {
+            const Entry& entry = entries.at(it->entry);
+
+            if (!result.contains(entry.key))
+            {
+                result.insert(entry.key, entry.values);
+
+                if (maxResults > 0 && result.size() >= maxResults)
+                {
+                    break;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Substring search.
+
+    if (folded.size() == 1)
+    {
+        // Nearly all tags match a single character, there is nothing to gain from an index.
+
+        for (QVector<Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it)
+        {
+            if (matches(*it, folded))
+            {
+                result.insert(it->key, it->values);
+
+                if (maxResults > 0 && result.size() >= maxResults)
+                {
+                    break;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Use the shortest posting list among all n-grams of the searched text as candidates.
+
+    const int size                  = qMin(folded.size(), 3);
+    const QVector<int>* candidates  = nullptr;
+
+    for (int i = 0 ; i + size <= folded.size() ; ++i)
+    {
+        QHash<quint64, QVector<int> >::const_iterator it = grams.constFind(gram(folded.constData() + i, size));
+
+        if (it == grams.constEnd())
+        {
+            return result;
+        }
+
+        if (!candidates || it->size() < candidates->size())
+        {
+            candidates = &(*it);
+        }
+    }
+
+    for (QVector<int>::const_iterator it = candidates->constBegin(); it != candidates->constEnd(); ++it)
+    {
+        const Entry& entry = entries.at(*it);
+
+        if (matches(entry, folded))
+        {
+            result.insert(entry.key, entry.values);
+
+            if (maxResults > 0 && result.size() >= maxResults)
+            {
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+// -------------------------------------------------------------------------------------------
+
+static std::shared_ptr<const KExiv2TagsIndex> tagsIndex(const KExiv2& meta)
+{
+    // The catalogue only changes when XMP namespaces are registered or unregistered, as done
+    // by initializeExiv2(). The index is built again for each new revision of the namespaces.
+    // A search running meanwhile keeps its own reference to the previous index.
+
+    static QMutex                                 mutex;
+    static std::shared_ptr<const KExiv2TagsIndex> index;
+    static int                                    revision = 0;
+
+    const int current = KExiv2Private::xmpNamespacesRevision.loadAcquire();
+
+    QMutexLocker lock(&mutex);
+
+    if (!index || revision != current)
+    {
+        index    = std::make_shared<const KExiv2TagsIndex>(meta);
+        revision = current;
+    }
+
+    return index;
+}
+
+KExiv2::TagsMap KExiv2::searchTagsList(const QString& text, TagsSearchMode mode, int maxResults) const
+{
+    if (text.isEmpty())
+    {
+        return TagsMap();
+    }
+
+    return tagsIndex(*this)->search(text, mode, maxResults);
+}
+
+}  // NameSpace KExiv2Iface
@@ -0,0 +1,273 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "kexiv2thumbnailbatch.h"
+
+// C++ includes
+
+#include <atomic>
+#include <map>
+
+// Qt includes
+
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+// Local includes
+
+#include "kexiv2.h"
+#include "libkexiv2_debug.h"
+
+namespace KExiv2Iface
+{
+
+/** The pixels reserved for a file when the target size is not valid, and
+ *  the thumbnails are the embedded images at full size.
+ */
+static const qint64 s_fullSizeEstimate = 2 * 1024 * 1024;
+
+static qint64 pixelsCount(const QImage& image)
+{
+    return (qint64)image.width() * image.height();
+}
+
+class KExiv2ThumbnailBatchPrivate
+{
+public:
+
+    KExiv2ThumbnailBatchPrivate()
+      : maxThreads(0),
+        maxPixels(32 * 1024 * 1024),
+        order(KExiv2ThumbnailBatch::CompletionOrder),
+        cancelled(false),
+        running(0),
+        pixelsInFlight(0)
+    {
+    }
+
+    /** Extracts the thumbnail of a file, in a worker thread.
+     */
+    void extract(int index, const QString& filePath, const QSize& targetSize, qint64 estimate)
+    {
+        KExiv2ThumbnailBatch::Result result;
+        result.index    = index;
+        result.filePath = filePath;
+
+        if (!cancelled)
+        {
+            KExiv2 meta;
+
+            if (meta.load(filePath))
+            {
+                result.thumbnail = meta.bestThumbnail(targetSize);
+            }
+
+            if (result.thumbnail.isNull())
+            {
+                qCDebug(LIBKEXIV2_LOG) << "No thumbnail found in" << filePath;
+            }
+        }
+
+        QMutexLocker lock(&mutex);
+
+        // Replace the reservation with the actual size of the thumbnail.
+        pixelsInFlight += pixelsCount(result.thumbnail) - estimate;
+        --running;
+        results.emplace(index, result);
+        finished.wakeAll();
+    }
+
+public:
+
+    int                                         maxThreads;
+    qint64                                      maxPixels;
+    KExiv2ThumbnailBatch::DeliveryOrder         order;
+
+    std::atomic<bool>                           cancelled;
+
+    /// Shared with the workers, protected by the mutex.
+    QMutex                                      mutex;
+    QWaitCondition                              finished;
+    int                                         running;
+    qint64                                      pixelsInFlight;
+
+    /// The thumbnails extracted and not delivered yet, by index.
+    std::map<int, KExiv2ThumbnailBatch::Result> results;
+};
+
+KExiv2ThumbnailBatch::KExiv2ThumbnailBatch()
+    : d(new KExiv2ThumbnailBatchPrivate)
+{
+}
+
+KExiv2ThumbnailBatch::~KExiv2ThumbnailBatch() = default;
+
+void KExiv2ThumbnailBatch::setMaximumThreads(int maxThreads)
+{
+    d->maxThreads = qMax(maxThreads, 0);
+}
+
+int KExiv2ThumbnailBatch::maximumThreads() const
+{
+    return d->maxThreads;
+}
+
+void KExiv2ThumbnailBatch::setMaximumPixelsInFlight(qint64 pixels)
+{
+    d->maxPixels = qMax(pixels, (qint64)1);
+}
+
+qint64 KExiv2ThumbnailBatch::maximumPixelsInFlight() const
+{
+    return d->maxPixels;
+}
+
+void KExiv2ThumbnailBatch::setDeliveryOrder(DeliveryOrder order)
+{
+    d->order = order;
+}
+
+KExiv2ThumbnailBatch::DeliveryOrder KExiv2ThumbnailBatch::deliveryOrder() const
+{
+    return d->order;
+}
+
+int KExiv2ThumbnailBatch::process(const QStringList& filePaths, const QSize& targetSize, const ResultHandler& handler)
+{
+    const int    count      = filePaths.size();
+    const int    maxThreads = (d->maxThreads > 0) ? d->maxThreads : QThread::idealThreadCount();
+    const qint64 estimate   = targetSize.isValid() ? qMax((qint64)targetSize.width() * targetSize.height(), (qint64)1)
+                                                   : s_fullSizeEstimate;
+
+    KExiv2ThumbnailBatchPrivate* const priv = d.get();
+    priv->cancelled                         = false;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(maxThreads);
+
+    int thumbnails    = 0;
+    int next          = 0;
+    int nextToDeliver = 0;
+
+    QMutexLocker lock(&priv->mutex);
+    priv->running        = 0;
+    priv->pixelsInFlight = 0;
+    priv->results.clear();
+
+    while (true)
+    {
+        const bool stop = priv->cancelled;
+
+        // Start new files while the budget allows it. A file is always started when
+        // no other one is running, so a budget smaller than a thumbnail cannot stall.
+
+        while (!stop && next < count && priv->running < maxThreads &&
+               (priv->running == 0 || priv->pixelsInFlight + estimate <= priv->maxPixels))
+        {
+            const int     index    = next++;
+            const QString filePath = filePaths.at(index);
+
+            priv->pixelsInFlight += estimate;
+            ++priv->running;
+
+            pool.start([priv, index, filePath, targetSize, estimate]()
+                {
+                    priv->extract(index, filePath, targetSize, estimate);
+                });
+        }
+
+        // Take the thumbnails which can be delivered.
+
+        QList<Result> ready;
+
+        if (stop)
+        {
+            for (const auto& it : priv->results)
+            {
+                priv->pixelsInFlight -= pixelsCount(it.second.thumbnail);
+            }
+
+            priv->results.clear();
+        }
+        else if (priv->order == CompletionOrder)
+        {
+            for (auto& it : priv->results)
+            {
+                ready << std::move(it.second);
+            }
+
+            priv->results.clear();
+        }
+        else
+        {
+            std::map<int, Result>::iterator it;
+
+            while ((it = priv->results.find(nextToDeliver)) != priv->results.end())
+            {
+                ready << std::move(it->second);
+                priv->results.erase(it);
+                ++nextToDeliver;
+            }
+        }
+
+        if (ready.isEmpty())
+        {
+            if (priv->running == 0 && (stop || next >= count))
+            {
+                break;
+            }
+
+            priv->finished.wait(&priv->mutex);
+            continue;
+        }
+
+        // Deliver without holding the lock, the workers go on meanwhile.
+
+        lock.unlock();
+
+        for (const Result& result : std::as_const(ready))
+        {
+            if (priv->cancelled)
+            {
+                break;
+            }
+
+            if (!result.thumbnail.isNull())
+            {
+                ++thumbnails;
+            }
+
+            handler(result);
+        }
+
+        lock.relock();
+
+        for (const Result& result : std::as_const(ready))
+        {
+            priv->pixelsInFlight -= pixelsCount(result.thumbnail);
+        }
+    }
+
+    lock.unlock();
+    pool.waitForDone();
+
+    return thumbnails;
+}
+
+void KExiv2ThumbnailBatch::cancel()
+{
+    d->cancelled = true;
+
+    // Wake up process() to drop the pending thumbnails.
+    QMutexLocker lock(&d->mutex);
+    d->finished.wakeAll();
+}
+
+} // namespace KExiv2Iface
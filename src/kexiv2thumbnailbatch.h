@@ -0,0 +1,146 @@
+/*
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef KEXIV2THUMBNAILBATCH_H
+#define KEXIV2THUMBNAILBATCH_H
+
+// Std
+
+#include <functional>
+#include <memory>
+
+// Qt includes
+
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+
+// Local includes
+
+#include "libkexiv2_export.h"
+
+namespace KExiv2Iface
+{
+
+/*!
+ * \class KExiv2Iface::KExiv2ThumbnailBatch
+ * \inmodule KExiv2
+ * \inheaderfile KExiv2/KExiv2ThumbnailBatch
+ *
+ * \brief Extracts the thumbnails of many image files in parallel.
+ *
+ * For each file, the thumbnail is taken from the embedded images with
+ * KExiv2::bestThumbnail(): the Exif thumbnail, the IPTC preview or the previews
+ * listed by KExiv2Previews. Files without embedded images give a null thumbnail.
+ *
+ * The files are processed on a pool of worker threads. The number of decoded
+ * pixels in flight, in the workers and in the thumbnails waiting to be delivered,
+ * is capped by setMaximumPixelsInFlight(): no new file is started while the
+ * budget is used up.
+ *
+ * KExiv2::initializeExiv2() must have been called before.
+ */
+class LIBKEXIV2_EXPORT KExiv2ThumbnailBatch
+{
+public:
+
+    /*!
+     * The order in which the thumbnails are delivered.
+     *
+     * \value CompletionOrder
+     *        As soon as they are extracted.
+     * \value PriorityOrder
+     *        In the order of the files list. Sort the list by priority, as the
+     *        visible items of a view first: the files are also started in this order.
+     */
+    enum DeliveryOrder
+    {
+        CompletionOrder = 0,
+        PriorityOrder
+    };
+
+    /*!
+     * A thumbnail extracted from a file.
+     */
+    struct Result
+    {
+        /*! The position of the file in the list.
+         */
+        int     index = -1;
+
+        QString filePath;
+
+        /*! The thumbnail, or a null image if the file has no embedded image.
+         */
+        QImage  thumbnail;
+    };
+
+    /*!
+     * The function called with each thumbnail, in the thread calling process().
+     */
+    typedef std::function<void(const Result&)> ResultHandler;
+
+public:
+
+    /*!
+     * Constructs a batch using QThread::idealThreadCount() threads.
+     */
+    KExiv2ThumbnailBatch();
+    /*!
+     */
+    ~KExiv2ThumbnailBatch();
+
+    /*!
+     * Sets the number of worker threads, or QThread::idealThreadCount() if \a maxThreads is 0.
+     */
+    void setMaximumThreads(int maxThreads);
+    /*!
+     */
+    int  maximumThreads() const;
+
+    /*!
+     * Sets the maximum number of decoded pixels in flight. The default is 32 megapixels,
+     * 128 MB for 32 bits images. A file is always started when no other file is
+     * being processed, whatever the budget.
+     */
+    void   setMaximumPixelsInFlight(qint64 pixels);
+    /*!
+     */
+    qint64 maximumPixelsInFlight() const;
+
+    /*!
+     * Sets the \a order in which the thumbnails are delivered. The default is CompletionOrder.
+     */
+    void          setDeliveryOrder(DeliveryOrder order);
+    /*!
+     */
+    DeliveryOrder deliveryOrder() const;
+
+    /*!
+     * Extracts the thumbnails of \a filePaths, scaled down to fit in \a targetSize, and calls
+     * \a handler with each one. Returns when all files are processed or the batch is cancelled,
+     * with the number of non null thumbnails delivered.
+     *
+     * The handler is called in the calling thread, never in the workers: a slow handler
+     * holds the thumbnails in flight and stops the start of new files.
+     */
+    int process(const QStringList& filePaths, const QSize& targetSize, const ResultHandler& handler);
+
+    /*!
+     * Stops a running process(): the files not started yet are skipped, and the thumbnails
+     * not delivered yet are dropped. Can be called from any thread, including the handler.
+     */
+    void cancel();
+
+private:
+
+    std::unique_ptr<class KExiv2ThumbnailBatchPrivate> const d;
+};
+
+} // namespace KExiv2Iface
+
+#endif // KEXIV2THUMBNAILBATCH_H
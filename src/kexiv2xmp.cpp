@@ -9,11 +9,221 @@
 
 #include "kexiv2.h"
 #include "kexiv2_p.h"
+#include "rotationmatrix.h"
 #include "libkexiv2_debug.h"
 
+// C++ includes
+
+#include <array>
+#include <utility>
+#include <vector>
+
+// Qt includes
+
+#include <QSet>
+
 namespace KExiv2Iface
 {
 
+#ifdef _XMP_SUPPORT_
+
+/** The fields of the area of a MWG region, in the order of the areas arrays below.
+ */
+enum RegionAreaField
+{
+    RegionAreaX = 0,
+    RegionAreaY,
+    RegionAreaW,
+    RegionAreaH,
+    RegionAreaUnit,
+    RegionAreaFields
+};
+
+static const char s_regionsKey[]    = "Xmp.mwg-rs.Regions";
+static const char s_regionListKey[] = "Xmp.mwg-rs.Regions/mwg-rs:RegionList";
+
+/** Parses a key of a field of a MWG region, as
+ *  "Xmp.mwg-rs.Regions/mwg-rs:RegionList[1]/mwg-rs:Name".
+ *  Returns \c false if the key is not inside a region, else sets the 0 based
+ *  \a index of the region and the position of the \a field in the key, after
+ *  the "]/" following the index.
+ */
+static bool parseRegionKey(const std::string& key, int& index, size_t& field)
+{
+    static const size_t prefixLen = sizeof(s_regionListKey);
+
+    if (key.size() <= prefixLen || key.compare(0, prefixLen - 1, s_regionListKey) != 0 || key[prefixLen - 1] != '[')
+        return false;
+
+    size_t pos = prefixLen;
+    int    n   = 0;
+
+    while (pos < key.size() && key[pos] >= '0' && key[pos] <= '9')
+    {
+        n = n * 10 + (key[pos] - '0');
+        ++pos;
+    }
+
+    if (pos == prefixLen || n < 1 || key.compare(pos, 2, "]/") != 0)
+        return false;
+
+    index = n - 1;
+    field = pos + 2;
+
+    return true;
+}
+
+/** Parses a key of the area of a MWG region, as
+ *  "Xmp.mwg-rs.Regions/mwg-rs:RegionList[1]/mwg-rs:Area/stArea:x".
+ *  Returns \c false if the key is not one of the area fields, else sets
+ *  the 0 based \a index of the region and the \a field.
+ */
+static bool parseRegionAreaKey(const std::string& key, int& index, RegionAreaField& field)
+{
+    static const char   area[]  = "mwg-rs:Area/stArea:";
+    static const size_t areaLen = sizeof(area) - 1;
+
+    size_t pos;
+
+    if (!parseRegionKey(key, index, pos) || key.compare(pos, areaLen, area) != 0)
+        return false;
+
+    const char* const name = key.c_str() + pos + areaLen;
+
+    if      (qstrcmp(name, "x") == 0)    field = RegionAreaX;
+    else if (qstrcmp(name, "y") == 0)    field = RegionAreaY;
+    else if (qstrcmp(name, "w") == 0)    field = RegionAreaW;
+    else if (qstrcmp(name, "h") == 0)    field = RegionAreaH;
+    else if (qstrcmp(name, "unit") == 0) field = RegionAreaUnit;
+    else return false;
+
+    return true;
+}
+
+/** Formats a normalized coordinate for the XMP text values.
+ */
+static std::string xmpReal(double value)
+{
+    return QByteArray::number(value, 'g', 9).toStdString();
+}
+
+/** The entries to remove from and to add to an XMP bag or seq, hashed once
+ *  to be applied to the arrays of many containers.
+ */
+class XmpArrayEdit
+{
+public:
+
+    XmpArrayEdit(const QStringList& entriesToAdd, const QStringList& entriesToRemove)
+    {
+        removed.reserve(entriesToRemove.size());
+
+        for (const QString& entry : entriesToRemove)
+        {
+            removed.insert(entry.toUtf8());
+        }
+
+        added.reserve(entriesToAdd.size());
+
+        for (const QString& entry : entriesToAdd)
+        {
+            added << entry.toUtf8();
+        }
+    }
+
+    /** Removes the entries from the array \a key of the \a type xmpBag or xmpSeq, then appends the
+     *  entries which are not present yet. The other items are left in place. Nothing is copied or
+     *  written if the array does not change. Returns true if the array has been changed.
+     */
+    bool apply(KExiv2Private& d, const Exiv2::XmpKey& key, Exiv2::TypeId type) const
+    {
+        const Exiv2::XmpData& constXmp          = std::as_const(d).xmpMetadata();
+        Exiv2::XmpData::const_iterator it       = constXmp.findKey(key);
+        const Exiv2::XmpArrayValue* const array = (it != constXmp.end() && it->typeId() == type)
+                                                  ? dynamic_cast<const Exiv2::XmpArrayValue*>(&it->value())
+                                                  : nullptr;
+
+        std::vector<std::string> items;
+        QSet<QByteArray>         present;
+        // A tag of another type is replaced, but only by new entries.
+        bool                     changed = (it != constXmp.end() && !array && !added.isEmpty());
+
+        if (array)
+        {
+            const size_t count = static_cast<size_t>(array->count());
+
+            items.reserve(count + added.size());
+            present.reserve(count + added.size());
+
+            for (size_t i = 0 ; i < count ; ++i)
+            {
+                std::string item = array->toString(i);
+                QByteArray  utf8(item.data(), item.size());
+
+                if (removed.contains(utf8))
+                {
+                    changed = true;
+                    continue;
+                }
+
+                items.push_back(std::move(item));
+                present.insert(utf8);
+            }
+        }
+
+        for (const QByteArray& entry : added)
+        {
+            if (present.contains(entry))
+                continue;
+
+            present.insert(entry);
+            items.push_back(entry.toStdString());
+            changed = true;
+        }
+
+        if (!changed)
+            return false;
+
+        const long     pos = (it != constXmp.end()) ? (it - constXmp.begin()) : -1;
+        Exiv2::XmpData& xmp = d.xmpMetadata();
+
+        if (items.empty())
+        {
+            if (pos >= 0)
+            {
+                xmp.erase(xmp.begin() + pos);
+            }
+
+            return true;
+        }
+
+        Exiv2::XmpArrayValue value(type);
+
+        for (const std::string& item : items)
+        {
+            value.read(item);
+        }
+
+        if (pos >= 0)
+        {
+            xmp.begin()[pos].setValue(&value);
+        }
+        else
+        {
+            xmp.add(key, &value);
+        }
+
+        return true;
+    }
+
+private:
+
+    QSet<QByteArray>  removed;
+    QList<QByteArray> added;
+};
+
+#endif // _XMP_SUPPORT_
+
 bool KExiv2::canWriteXmp(const QString& filePath)
 {
 #ifdef _XMP_SUPPORT_
@@ -59,7 +269,7 @@ bool KExiv2::hasXmp() const
 {
 #ifdef _XMP_SUPPORT_
 
-    return !d->xmpMetadata().empty();
+    return !std::as_const(*d).xmpMetadata().empty();
 
 #else
 
@@ -97,11 +307,11 @@ QByteArray KExiv2::getXmp() const
 
     try
     {
-        if (!d->xmpMetadata().empty())
+        if (!std::as_const(*d).xmpMetadata().empty())
         {
 
             std::string xmpPacket;
-            Exiv2::XmpParser::encode(xmpPacket, d->xmpMetadata());
+            Exiv2::XmpParser::encode(xmpPacket, std::as_const(*d).xmpMetadata());
             QByteArray data(xmpPacket.data(), xmpPacket.size());
             return data;
         }
@@ -165,12 +375,12 @@ KExiv2::MetaDataMap KExiv2::getXmpTagsDataList(const QStringList& xmpKeysFilter,
 {
 #ifdef _XMP_SUPPORT_
 
-    if (d->xmpMetadata().empty())
+    if (std::as_const(*d).xmpMetadata().empty())
        return MetaDataMap();
 
     try
     {
-        Exiv2::XmpData xmpData = d->xmpMetadata();
+        Exiv2::XmpData xmpData = std::as_const(*d).xmpMetadata();
         xmpData.sortByKey();
 
         QString     ifDItemName;
@@ -339,9 +549,9 @@ QString KExiv2::getXmpTagString(const char* xmpTagName, bool escapeCR) const
 
     try
     {
-        Exiv2::XmpData xmpData(d->xmpMetadata());
+        const Exiv2::XmpData& xmpData = std::as_const(*d).xmpMetadata();
         Exiv2::XmpKey key(xmpTagName);
-        Exiv2::XmpData::iterator it = xmpData.findKey(key);
+        Exiv2::XmpData::const_iterator it = xmpData.findKey(key);
 
         if (it != xmpData.end())
         {
@@ -378,7 +588,7 @@ bool KExiv2::setXmpTagString(const char* xmpTagName, const QString& value, bool
 {
 #ifdef _XMP_SUPPORT_
 
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -417,7 +627,7 @@ bool KExiv2::setXmpTagString(const char* xmpTagName, const QString& value,
 {
 #ifdef _XMP_SUPPORT_
 
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -470,9 +680,9 @@ KExiv2::AltLangMap KExiv2::getXmpTagStringListLangAlt(const char* xmpTagName, bo
 
     try
     {
-        Exiv2::XmpData xmpData = d->xmpMetadata();
+        const Exiv2::XmpData& xmpData = std::as_const(*d).xmpMetadata();
 
-        for (Exiv2::XmpData::iterator it = xmpData.begin(); it != xmpData.end(); ++it)
+        for (Exiv2::XmpData::const_iterator it = xmpData.begin(); it != xmpData.end(); ++it)
         {
             if (it->key() == xmpTagName && it->typeId() == Exiv2::langAlt)
             {
@@ -519,7 +729,7 @@ bool KExiv2::setXmpTagStringListLangAlt(const char* xmpTagName, const KExiv2::Al
 {
 #ifdef _XMP_SUPPORT_
 
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -575,10 +785,10 @@ QString KExiv2::getXmpTagStringLangAlt(const char* xmpTagName, const QString& la
 
     try
     {
-        Exiv2::XmpData xmpData(d->xmpMetadata());
+        const Exiv2::XmpData& xmpData = std::as_const(*d).xmpMetadata();
         Exiv2::XmpKey key(xmpTagName);
 
-        for (Exiv2::XmpData::iterator it = xmpData.begin(); it != xmpData.end(); ++it)
+        for (Exiv2::XmpData::const_iterator it = xmpData.begin(); it != xmpData.end(); ++it)
         {
             if (it->key() == xmpTagName && it->typeId() == Exiv2::langAlt)
             {
@@ -626,7 +836,7 @@ bool KExiv2::setXmpTagStringLangAlt(const char* xmpTagName, const QString& value
 {
 #ifdef _XMP_SUPPORT_
 
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -694,9 +904,9 @@ QStringList KExiv2::getXmpTagStringSeq(const char* xmpTagName, bool escapeCR) co
 
     try
     {
-        Exiv2::XmpData xmpData(d->xmpMetadata());
+        const Exiv2::XmpData& xmpData = std::as_const(*d).xmpMetadata();
         Exiv2::XmpKey key(xmpTagName);
-        Exiv2::XmpData::iterator it = xmpData.findKey(key);
+        Exiv2::XmpData::const_iterator it = xmpData.findKey(key);
 
         if (it != xmpData.end())
         {
@@ -745,7 +955,7 @@ bool KExiv2::setXmpTagStringSeq(const char* xmpTagName, const QStringList& seq,
 {
 #ifdef _XMP_SUPPORT_
 
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -799,9 +1009,9 @@ QStringList KExiv2::getXmpTagStringBag(const char* xmpTagName, bool escapeCR) co
 
     try
     {
-        Exiv2::XmpData xmpData(d->xmpMetadata());
+        const Exiv2::XmpData& xmpData = std::as_const(*d).xmpMetadata();
         Exiv2::XmpKey key(xmpTagName);
-        Exiv2::XmpData::iterator it = xmpData.findKey(key);
+        Exiv2::XmpData::const_iterator it = xmpData.findKey(key);
 
         if (it != xmpData.end())
         {
@@ -849,7 +1059,7 @@ bool KExiv2::setXmpTagStringBag(const char* xmpTagName, const QStringList& bag,
 {
 #ifdef _XMP_SUPPORT_
 
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -900,45 +1110,117 @@ bool KExiv2::setXmpTagStringBag(const char* xmpTagName, const QStringList& bag,
 bool KExiv2::addToXmpTagStringBag(const char* xmpTagName, const QStringList& entriesToAdd,
                                      bool setProgramName) const
 {
-    if (!setProgramId(setProgramName))
+    return editXmpTagStringArray(xmpTagName, Exiv2::xmpBag, entriesToAdd, QStringList(), setProgramName);
+}
+
+bool KExiv2::removeFromXmpTagStringBag(const char* xmpTagName, const QStringList& entriesToRemove,
+                                       bool setProgramName) const
+{
+    return editXmpTagStringArray(xmpTagName, Exiv2::xmpBag, QStringList(), entriesToRemove, setProgramName);
+}
+
+bool KExiv2::addToXmpTagStringSeq(const char* xmpTagName, const QStringList& entriesToAdd,
+                                  bool setProgramName) const
+{
+    return editXmpTagStringArray(xmpTagName, Exiv2::xmpSeq, entriesToAdd, QStringList(), setProgramName);
+}
+
+bool KExiv2::removeFromXmpTagStringSeq(const char* xmpTagName, const QStringList& entriesToRemove,
+                                       bool setProgramName) const
+{
+    return editXmpTagStringArray(xmpTagName, Exiv2::xmpSeq, QStringList(), entriesToRemove, setProgramName);
+}
+
+bool KExiv2::editXmpTagStringArray(const char* xmpTagName, int type, const QStringList& entriesToAdd,
+                                   const QStringList& entriesToRemove, bool setProgramName) const
+{
+#ifdef _XMP_SUPPORT_
+
+    if (!applyProgramId(setProgramName))
         return false;
 
-    QStringList oldEntries = getXmpTagStringBag(xmpTagName, false);
-    QStringList newEntries = entriesToAdd;
+    try
+    {
+        XmpArrayEdit(entriesToAdd, entriesToRemove).apply(*d, Exiv2::XmpKey(xmpTagName), (Exiv2::TypeId)type);
 
-    // Create a list of keywords including old one which already exists.
-    for (QStringList::const_iterator it = oldEntries.constBegin(); it != oldEntries.constEnd(); ++it )
+        return true;
+    }
+    catch( Exiv2::Error& e )
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot edit Xmp tag string array using Exiv2 "), e);
+    }
+    catch(...)
     {
-        if (!newEntries.contains(*it))
-            newEntries.append(*it);
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
     }
 
-    if (setXmpTagStringBag(xmpTagName, newEntries, false))
-        return true;
+#else
+
+    Q_UNUSED(xmpTagName);
+    Q_UNUSED(type);
+    Q_UNUSED(entriesToAdd);
+    Q_UNUSED(entriesToRemove);
+    Q_UNUSED(setProgramName);
+
+#endif // _XMP_SUPPORT_
 
     return false;
 }
 
-bool KExiv2::removeFromXmpTagStringBag(const char* xmpTagName, const QStringList& entriesToRemove,
-                                       bool setProgramName) const
+int KExiv2::editXmpTagStringBag(const QList<KExiv2*>& metadata, const char* xmpTagName,
+                                const QStringList& entriesToAdd, const QStringList& entriesToRemove,
+                                bool setProgramName)
 {
-    if (!setProgramId(setProgramName))
-        return false;
+    int changed = 0;
 
-    QStringList currentEntries = getXmpTagStringBag(xmpTagName, false);
-    QStringList newEntries;
+#ifdef _XMP_SUPPORT_
 
-    // Create a list of current keywords except those that shall be removed
-    for (QStringList::const_iterator it = currentEntries.constBegin(); it != currentEntries.constEnd(); ++it )
+    try
     {
-        if (!entriesToRemove.contains(*it))
-            newEntries.append(*it);
+        // Hash the entries and parse the key once for all containers.
+
+        const XmpArrayEdit  edit(entriesToAdd, entriesToRemove);
+        const Exiv2::XmpKey key(xmpTagName);
+
+        for (KExiv2* const meta : metadata)
+        {
+            try
+            {
+                if (meta && meta->applyProgramId(setProgramName) && edit.apply(*meta->d, key, Exiv2::xmpBag))
+                {
+                    ++changed;
+                }
+            }
+            catch( Exiv2::Error& e )
+            {
+                meta->d->printExiv2ExceptionError(QString::fromLatin1("Cannot edit Xmp tag string Bag using Exiv2 "), e);
+            }
+            catch(...)
+            {
+                qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+            }
+        }
+    }
+    catch( Exiv2::Error& e )
+    {
+        KExiv2Private::printExiv2ExceptionError(QString::fromLatin1("Cannot edit Xmp tag string Bag using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
     }
 
-    if (setXmpTagStringBag(xmpTagName, newEntries, false))
-        return true;
+#else
 
-    return false;
+    Q_UNUSED(metadata);
+    Q_UNUSED(xmpTagName);
+    Q_UNUSED(entriesToAdd);
+    Q_UNUSED(entriesToRemove);
+    Q_UNUSED(setProgramName);
+
+#endif // _XMP_SUPPORT_
+
+    return changed;
 }
 
 QVariant KExiv2::getXmpTagVariant(const char* xmpTagName, bool rationalAsListOfInts, bool stringEscapeCR) const
@@ -946,9 +1228,9 @@ QVariant KExiv2::getXmpTagVariant(const char* xmpTagName, bool rationalAsListOfI
 #ifdef _XMP_SUPPORT_
     try
     {
-        Exiv2::XmpData xmpData(d->xmpMetadata());
+        const Exiv2::XmpData& xmpData = std::as_const(*d).xmpMetadata();
         Exiv2::XmpKey key(xmpTagName);
-        Exiv2::XmpData::iterator it = xmpData.findKey(key);
+        Exiv2::XmpData::const_iterator it = xmpData.findKey(key);
 
         if (it != xmpData.end())
         {
@@ -987,7 +1269,7 @@ QVariant KExiv2::getXmpTagVariant(const char* xmpTagName, bool rationalAsListOfI
                 case Exiv2::date:
                 case Exiv2::time:
                 {
-                    QDateTime dateTime = QDateTime::fromString(QString::fromLatin1(it->toString().c_str()), Qt::ISODate);
+                    QDateTime dateTime = KExiv2Private::convertDateTimeValue(it->value());
                     return QVariant(dateTime);
                 }
                 case Exiv2::asciiString:
@@ -1079,6 +1361,7 @@ bool KExiv2::registerXmpNameSpace(const QString& uri, const QString& prefix)
             ns.append(QString::fromLatin1("/"));
 
         Exiv2::XmpProperties::registerNs(ns.toLatin1().constData(), prefix.toLatin1().constData());
+        KExiv2Private::xmpNamespacesRevision.ref();
         return true;
     }
     catch( Exiv2::Error& e )
@@ -1112,6 +1395,7 @@ bool KExiv2::unregisterXmpNameSpace(const QString& uri)
             ns.append(QString::fromLatin1("/"));
 
         Exiv2::XmpProperties::unregisterNs(ns.toLatin1().constData());
+        KExiv2Private::xmpNamespacesRevision.ref();
         return true;
     }
     catch( Exiv2::Error& e )
@@ -1136,7 +1420,7 @@ bool KExiv2::removeXmpTag(const char* xmpTagName, bool setProgramName) const
 {
 #ifdef _XMP_SUPPORT_
 
-    if (!setProgramId(setProgramName))
+    if (!applyProgramId(setProgramName))
         return false;
 
     try
@@ -1214,6 +1498,443 @@ bool KExiv2::removeXmpSubjects(const QStringList& subjectsToRemove, bool setProg
     return removeFromXmpTagStringBag("Xmp.iptc.SubjectCode", subjectsToRemove, setProgramName);
 }
 
+QList<KExiv2::FaceRegion> KExiv2::getFaceRegions() const
+{
+    QList<FaceRegion> regions;
+
+#ifdef _XMP_SUPPORT_
+
+    try
+    {
+        struct Entry
+        {
+            FaceRegion region;
+            double     area[4]    = { 0.0, 0.0, 0.0, 0.0 };
+            int        fields     = 0;
+            bool       normalized = true;
+            bool       found      = false;
+        };
+
+        std::vector<Entry> entries;
+        const Exiv2::XmpData& xmpData = std::as_const(*d).xmpMetadata();
+
+        for (Exiv2::XmpData::const_iterator it = xmpData.begin(); it != xmpData.end(); ++it)
+        {
+            const std::string& key = it->key();
+            int                index;
+            size_t             pos;
+
+            if (!parseRegionKey(key, index, pos))
+                continue;
+
+            if ((size_t)index >= entries.size())
+                entries.resize(index + 1);
+
+            Entry& entry = entries[index];
+            RegionAreaField field;
+
+            entry.region.index = index;
+
+            if (key.compare(pos, std::string::npos, "mwg-rs:Name") == 0)
+            {
+                entry.region.name  = QString::fromUtf8(it->toString().c_str());
+                entry.found        = true;
+            }
+            else if (key.compare(pos, std::string::npos, "mwg-rs:Type") == 0)
+            {
+                entry.region.type  = QString::fromUtf8(it->toString().c_str());
+                entry.found        = true;
+            }
+            else if (parseRegionAreaKey(key, index, field))
+            {
+                if (field == RegionAreaUnit)
+                {
+                    entry.normalized = (it->toString() == "normalized");
+                }
+                else
+                {
+                    entry.area[field] = QByteArray::fromStdString(it->toString()).toDouble();
+                    entry.fields     |= (1 << field);
+                }
+
+                entry.found = true;
+            }
+        }
+
+        regions.reserve(entries.size());
+
+        for (Entry& entry : entries)
+        {
+            if (!entry.found)
+                continue;
+
+            // MWG stores the center of the area.
+
+            if (entry.fields == 0xF && entry.normalized)
+            {
+                entry.region.area = QRectF(entry.area[RegionAreaX] - entry.area[RegionAreaW] / 2.0,
+                                           entry.area[RegionAreaY] - entry.area[RegionAreaH] / 2.0,
+                                           entry.area[RegionAreaW], entry.area[RegionAreaH]);
+            }
+
+            regions << std::move(entry.region);
+        }
+    }
+    catch( Exiv2::Error& e )
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot get Xmp face regions using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+#endif // _XMP_SUPPORT_
+
+    return regions;
+}
+
+bool KExiv2::setFaceRegions(const QList<FaceRegion>& regions, bool setProgramName) const
+{
+#ifdef _XMP_SUPPORT_
+
+    if (!applyProgramId(setProgramName))
+        return false;
+
+    try
+    {
+        // Copy the XMP metadata without the region list, or without the whole
+        // regions structure if there are no regions left, in one pass.
+
+        static const char dimensionsKey[] = "Xmp.mwg-rs.Regions/mwg-rs:AppliedToDimensions";
+
+        static const char   areaField[] = "mwg-rs:Area";
+        static const size_t areaLen     = sizeof(areaField) - 1;
+
+        // The fields of a current region which FaceRegion does not describe, with the
+        // position of the field in their key, to be copied to the new regions.
+        struct Source
+        {
+            std::vector<std::pair<size_t, const Exiv2::Xmpdatum*> > area;
+            std::vector<std::pair<size_t, const Exiv2::Xmpdatum*> > others;
+            bool                                                    normalized = true;
+        };
+
+        const Exiv2::XmpData& xmpData = std::as_const(*d).xmpMetadata();
+        const std::string     removed = regions.isEmpty() ? std::string(s_regionsKey) : std::string(s_regionListKey);
+        bool hasRegions               = false;
+        bool hasDimensions            = false;
+        std::vector<Source>   sources;
+
+        Exiv2::XmpData rebuilt;
+        rebuilt.setPacket(xmpData.xmpPacket());
+        rebuilt.usePacket(xmpData.usePacket());
+
+        for (Exiv2::XmpData::const_iterator it = xmpData.begin(); it != xmpData.end(); ++it)
+        {
+            const std::string& key = it->key();
+
+            if (key.compare(0, removed.size(), removed) == 0 &&
+                (key.size() == removed.size() || key[removed.size()] == '/' || key[removed.size()] == '['))
+            {
+                int    index;
+                size_t pos;
+
+                if (regions.isEmpty() || !parseRegionKey(key, index, pos) ||
+                    key.compare(pos, std::string::npos, "mwg-rs:Name") == 0 ||
+                    key.compare(pos, std::string::npos, "mwg-rs:Type") == 0)
+                {
+                    continue;
+                }
+
+                if ((size_t)index >= sources.size())
+                    sources.resize(index + 1);
+
+                Source& source = sources[index];
+
+                if (key.compare(pos, areaLen, areaField) == 0 &&
+                    (key.size() == pos + areaLen || key[pos + areaLen] == '/'))
+                {
+                    source.area.emplace_back(pos, &*it);
+
+                    if (key.compare(pos + areaLen, std::string::npos, "/stArea:unit") == 0)
+                        source.normalized = (it->toString() == "normalized");
+                }
+                else
+                {
+                    source.others.emplace_back(pos, &*it);
+                }
+
+                continue;
+            }
+
+            if (key == s_regionsKey)
+                hasRegions = true;
+            else if (key.compare(0, sizeof(dimensionsKey) - 1, dimensionsKey) == 0)
+                hasDimensions = true;
+
+            rebuilt.add(*it);
+        }
+
+        // Append the new regions.
+
+        if (!regions.isEmpty())
+        {
+            Exiv2::XmpTextValue structure;
+            structure.setXmpStruct();
+
+            Exiv2::XmpTextValue bag;
+            bag.setXmpArrayType(Exiv2::XmpValue::xaBag);
+
+            Exiv2::XmpTextValue text;
+
+            auto addText = [&rebuilt, &text](const std::string& key, const std::string& value)
+            {
+                text.read(value);
+                rebuilt.add(Exiv2::XmpKey(key), &text);
+            };
+
+            // Copies the fields of a current region under the new \a item key.
+            auto addFields = [&rebuilt](const std::string& item,
+                                        const std::vector<std::pair<size_t, const Exiv2::Xmpdatum*> >& fields)
+            {
+                for (const auto& field : fields)
+                {
+                    rebuilt.add(Exiv2::XmpKey(item + '/' + field.second->key().substr(field.first)),
+                                &field.second->value());
+                }
+            };
+
+            if (!hasRegions)
+            {
+                rebuilt.add(Exiv2::XmpKey(s_regionsKey), &structure);
+            }
+
+            const QSize size = getImageDimensions();
+
+            if (!hasDimensions && size.isValid())
+            {
+                rebuilt.add(Exiv2::XmpKey(dimensionsKey), &structure);
+                addText(std::string(dimensionsKey) + "/stDim:w",    std::to_string(size.width()));
+                addText(std::string(dimensionsKey) + "/stDim:h",    std::to_string(size.height()));
+                addText(std::string(dimensionsKey) + "/stDim:unit", "pixel");
+            }
+
+            rebuilt.add(Exiv2::XmpKey(s_regionListKey), &bag);
+
+            int i = 1;
+
+            for (const FaceRegion& region : regions)
+            {
+                const std::string item   = std::string(s_regionListKey) + '[' + std::to_string(i++) + ']';
+                const std::string area   = item + "/mwg-rs:Area";
+                const QRectF&     rect   = region.area;
+                const Source*     source = (region.index >= 0 && (size_t)region.index < sources.size())
+                                           ? &sources[region.index] : nullptr;
+
+                rebuilt.add(Exiv2::XmpKey(item), &structure);
+
+                if (!region.name.isEmpty())
+                {
+                    addText(item + "/mwg-rs:Name", region.name.toUtf8().toStdString());
+                }
+
+                if (!region.type.isEmpty())
+                {
+                    addText(item + "/mwg-rs:Type", region.type.toUtf8().toStdString());
+                }
+
+                if (rect.isValid())
+                {
+                    // MWG stores the center of the area.
+
+                    rebuilt.add(Exiv2::XmpKey(area), &structure);
+                    addText(area + "/stArea:x",    xmpReal(rect.x() + rect.width()  / 2.0));
+                    addText(area + "/stArea:y",    xmpReal(rect.y() + rect.height() / 2.0));
+                    addText(area + "/stArea:w",    xmpReal(rect.width()));
+                    addText(area + "/stArea:h",    xmpReal(rect.height()));
+                    addText(area + "/stArea:unit", "normalized");
+                }
+                else if (source && !source->normalized)
+                {
+                    addFields(item, source->area);
+                }
+
+                if (source)
+                {
+                    addFields(item, source->others);
+                }
+            }
+        }
+
+        d->xmpMetadata() = rebuilt;
+
+        return true;
+    }
+    catch( Exiv2::Error& e )
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot set Xmp face regions using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+#else
+
+    Q_UNUSED(regions);
+    Q_UNUSED(setProgramName);
+
+#endif // _XMP_SUPPORT_
+
+    return false;
+}
+
+bool KExiv2::transformXmpRegions(ImageOrientation transform, bool setProgramName) const
+{
+#ifdef _XMP_SUPPORT_
+
+    if (transform <= ORIENTATION_NORMAL || transform > ORIENTATION_LAST_VALUE)
+        return true;
+
+    if (!applyProgramId(setProgramName))
+        return false;
+
+    // The linear part of the transformation, applied to the coordinates centered on the
+    // image, maps the points as rotateExifQImage() maps the pixels.
+    const RotationMatrix matrix(transform);
+    const int            m[4] = { matrix.element(0, 0), matrix.element(1, 0),
+                                  matrix.element(0, 1), matrix.element(1, 1) };
+
+    static const long none = -1;
+
+    try
+    {
+        // First pass: find the positions of the area fields in the container, without detaching it.
+
+        const Exiv2::XmpData& constXmp = std::as_const(*d).xmpMetadata();
+        std::vector<std::array<long, RegionAreaFields> > positions;
+        long dimensions[2] = { none, none };
+
+        for (Exiv2::XmpData::const_iterator it = constXmp.begin(); it != constXmp.end(); ++it)
+        {
+            const std::string& key = it->key();
+            int                index;
+            RegionAreaField    field;
+
+            if (parseRegionAreaKey(key, index, field))
+            {
+                if ((size_t)index >= positions.size())
+                {
+                    std::array<long, RegionAreaFields> empty;
+                    empty.fill(none);
+                    positions.resize(index + 1, empty);
+                }
+
+                positions[index][field] = it - constXmp.begin();
+            }
+            else if (key == "Xmp.mwg-rs.Regions/mwg-rs:AppliedToDimensions/stDim:w")
+            {
+                dimensions[0] = it - constXmp.begin();
+            }
+            else if (key == "Xmp.mwg-rs.Regions/mwg-rs:AppliedToDimensions/stDim:h")
+            {
+                dimensions[1] = it - constXmp.begin();
+            }
+        }
+
+        // Gather the normalized areas.
+
+        std::vector<long>   areas;
+        std::vector<double> values[4];
+
+        for (const std::array<long, RegionAreaFields>& region : positions)
+        {
+            if (region[RegionAreaX] == none || region[RegionAreaY] == none ||
+                region[RegionAreaW] == none || region[RegionAreaH] == none)
+                continue;
+
+            if (region[RegionAreaUnit] != none &&
+                constXmp.begin()[region[RegionAreaUnit]].toString() != "normalized")
+                continue;
+
+            areas.push_back(&region - positions.data());
+
+            for (int i = 0 ; i < 4 ; ++i)
+            {
+                values[i].push_back(QByteArray::fromStdString(constXmp.begin()[region[i]].toString()).toDouble());
+            }
+        }
+
+        const bool transpose = (m[0] == 0);
+
+        if (areas.empty() && (!transpose || dimensions[0] == none || dimensions[1] == none))
+            return true;
+
+        // Transform all areas at once. The center of the area and its size are
+        // mapped independently, the size being only swapped by the transpositions.
+
+        const size_t     count = areas.size();
+        double* const    x     = values[RegionAreaX].data();
+        double* const    y     = values[RegionAreaY].data();
+        double* const    w     = values[RegionAreaW].data();
+        double* const    h     = values[RegionAreaH].data();
+
+        for (size_t i = 0 ; i < count ; ++i)
+        {
+            const double cx = x[i] - 0.5;
+            const double cy = y[i] - 0.5;
+            x[i]            = m[0] * cx + m[1] * cy + 0.5;
+            y[i]            = m[2] * cx + m[3] * cy + 0.5;
+        }
+
+        if (transpose)
+        {
+            values[RegionAreaW].swap(values[RegionAreaH]);
+        }
+
+        // Second pass: write the values back at the same positions.
+
+        Exiv2::XmpData& xmp = d->xmpMetadata();
+
+        for (size_t i = 0 ; i < count ; ++i)
+        {
+            const std::array<long, RegionAreaFields>& region = positions[areas[i]];
+
+            for (int j = 0 ; j < 4 ; ++j)
+            {
+                xmp.begin()[region[j]].setValue(xmpReal(values[j][i]));
+            }
+        }
+
+        if (transpose && dimensions[0] != none && dimensions[1] != none)
+        {
+            const std::string width = xmp.begin()[dimensions[0]].toString();
+            xmp.begin()[dimensions[0]].setValue(xmp.begin()[dimensions[1]].toString());
+            xmp.begin()[dimensions[1]].setValue(width);
+        }
+
+        return true;
+    }
+    catch( Exiv2::Error& e )
+    {
+        d->printExiv2ExceptionError(QString::fromLatin1("Cannot transform Xmp regions using Exiv2 "), e);
+    }
+    catch(...)
+    {
+        qCCritical(LIBKEXIV2_LOG) << "Default exception from Exiv2";
+    }
+
+#else
+
+    Q_UNUSED(transform);
+    Q_UNUSED(setProgramName);
+
+#endif // _XMP_SUPPORT_
+
+    return false;
+}
+
 KExiv2::TagsMap KExiv2::getXmpTagsList() const
 {
     TagsMap tagsMap;
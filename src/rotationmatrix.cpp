@@ -109,6 +109,33 @@ RotationMatrix matrix(KExiv2::ImageOrientation exifOrientation)
     return identity;
 }
 
+/** The Exif orientations of the products of the matrices above:
+ *  compositions[a - 1][b - 1] is the orientation of RotationMatrix(a) *= b.
+ */
+static constexpr quint8 compositions[8][8] =
+{
+    { 1, 2, 3, 4, 5, 6, 7, 8 },
+    { 2, 1, 4, 3, 6, 5, 8, 7 },
+    { 3, 4, 1, 2, 7, 8, 5, 6 },
+    { 4, 3, 2, 1, 8, 7, 6, 5 },
+    { 5, 8, 7, 6, 1, 4, 3, 2 },
+    { 6, 7, 8, 5, 2, 3, 4, 1 },
+    { 7, 6, 5, 8, 3, 2, 1, 4 },
+    { 8, 5, 6, 7, 4, 1, 2, 3 }
+};
+
+static_assert(compositions[KExiv2::ORIENTATION_ROT_90 - 1][KExiv2::ORIENTATION_ROT_270 - 1] == KExiv2::ORIENTATION_NORMAL,
+              "90 and 270 degrees rotations cancel out");
+
+/** Returns the row or column of an orientation in the compositions table,
+ *  where an unspecified or invalid orientation is the identity.
+ */
+static inline int compositionIndex(KExiv2::ImageOrientation orientation)
+{
+    return ((orientation >= KExiv2::ORIENTATION_NORMAL) && (orientation <= KExiv2::ORIENTATION_LAST_VALUE))
+           ? orientation - 1 : 0;
+}
+
 } // namespace Matrix
 
 RotationMatrix::RotationMatrix()
@@ -267,6 +294,16 @@ KExiv2::ImageOrientation RotationMatrix::exifOrientation() const
     return KExiv2::ORIENTATION_UNSPECIFIED;
 }
 
+KExiv2::ImageOrientation RotationMatrix::combine(KExiv2::ImageOrientation first, KExiv2::ImageOrientation second)
+{
+    return (KExiv2::ImageOrientation)Matrix::compositions[Matrix::compositionIndex(first)][Matrix::compositionIndex(second)];
+}
+
+int RotationMatrix::element(int row, int column) const
+{
+    return m[row & 1][column & 1];
+}
+
 QTransform RotationMatrix::toTransform() const
 {
     return toTransform(exifOrientation());
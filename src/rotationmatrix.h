@@ -125,6 +125,25 @@ public:
      */
     KExiv2::ImageOrientation exifOrientation() const;
 
+    /*!
+     * Returns the Exif orientation flag of the composition of \a first and \a second,
+     * as RotationMatrix(first) *= second, looked up in a constant table.
+     * Unspecified orientations are the identity.
+     *
+     * Transforming an image with \a second, then with \a first, is the same as transforming
+     * it with the returned orientation.
+     */
+    static KExiv2::ImageOrientation combine(KExiv2::ImageOrientation first, KExiv2::ImageOrientation second);
+
+    /*!
+     * Returns the coefficient of this matrix at \a row and \a column, both 0 or 1.
+     *
+     * A point at (x, y) from the center of the image, with y going down, is moved as the
+     * pixels by toTransform() to the row vector (x, y) * M:
+     * x' = M(0, 0) x + M(1, 0) y and y' = M(0, 1) x + M(1, 1) y.
+     */
+    int element(int row, int column) const;
+
     /*!
      * Returns a QTransform representing this matrix.
      * \since 5.1
@@ -0,0 +1,248 @@
+/*
+    A command line tool to benchmark the GPS coordinate string and rational conversions
+
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// C++ includes
+
+#include <cmath>
+#include <vector>
+
+// Qt includes
+
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringList>
+#include <QDebug>
+
+// Local includes
+
+#include "kexiv2.h"
+
+using namespace KExiv2Iface;
+
+// Former implementations based on QString::split() and QString::arg(), as reference.
+
+static QString legacyToGPSCoordinateString(const bool isLatitude, double coordinate)
+{
+    if (coordinate < -360.0 || coordinate > 360.0)
+        return QString();
+
+    char directionReference;
+
+    if (isLatitude)
+        directionReference = (coordinate < 0) ? 'S' : 'N';
+    else
+        directionReference = (coordinate < 0) ? 'W' : 'E';
+
+    coordinate     = fabs(coordinate);
+    int degrees    = (int)floor(coordinate);
+    coordinate     = coordinate - (double)(degrees);
+    double minutes = coordinate * 60.0;
+
+    QString coordinateString = QString::fromLatin1("%1,%2%3");
+    coordinateString         = coordinateString.arg(degrees);
+    coordinateString         = coordinateString.arg(minutes, 0, 'f', 8).arg(directionReference);
+
+    return coordinateString;
+}
+
+static bool legacyFromGPSCoordinateString(const QString& gpsString, double* const degrees)
+{
+    if (gpsString.isEmpty())
+        return false;
+
+    char directionReference = gpsString.at(gpsString.length() - 1).toUpper().toLatin1();
+    QString coordinate      = gpsString.left(gpsString.length() - 1);
+    QStringList parts       = coordinate.split(QString::fromLatin1(","));
+
+    if (parts.size() == 2)
+    {
+        *degrees =  parts[0].toLong();
+        *degrees += parts[1].toDouble() / 60.0;
+    }
+    else if (parts.size() == 3)
+    {
+        *degrees =  parts[0].toLong();
+        *degrees += parts[1].toLong() / 60.0;
+        *degrees += parts[2].toLong() / 3600.0;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (directionReference == 'W' || directionReference == 'S')
+        *degrees *= -1.0;
+
+    return true;
+}
+
+static void report(const char* const name, int count, qint64 nsecs)
+{
+    qDebug() << name << ":" << (double)nsecs / count << "ns per coordinate";
+}
+
+int main (int argc, char** argv)
+{
+    int count = 1000000;
+
+    if (argc == 2)
+    {
+        count = QString::fromLocal8Bit(argv[1]).toInt();
+    }
+
+    if (count <= 0)
+    {
+        qDebug() << "benchgpsconversions - benchmark GPS coordinate string and rational conversions";
+        qDebug() << "Usage: [coordinates count]";
+        return -1;
+    }
+
+    QList<double> coordinates;
+    coordinates.reserve(count);
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        coordinates.append(QRandomGenerator::global()->bounded(360.0) - 180.0);
+    }
+
+    QElapsedTimer timer;
+    QStringList   legacyStrings;
+    legacyStrings.reserve(count);
+
+    // Formatting.
+
+    timer.start();
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        legacyStrings.append(legacyToGPSCoordinateString(false, coordinates.at(i)));
+    }
+
+    report("Format, QString::arg()", count, timer.nsecsElapsed());
+
+    char buffer[32];
+    int  length = 0;
+    timer.start();
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        length += KExiv2::convertToGPSCoordinateString(false, coordinates.at(i), buffer, sizeof(buffer));
+    }
+
+    report("Format, char buffer", count, timer.nsecsElapsed());
+
+    timer.start();
+    const QStringList strings = KExiv2::convertToGPSCoordinateStrings(false, coordinates);
+    report("Format, batch", count, timer.nsecsElapsed());
+
+    // Parsing.
+
+    double legacySum = 0.0;
+    double value     = 0.0;
+    timer.start();
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        if (legacyFromGPSCoordinateString(legacyStrings.at(i), &value))
+            legacySum += value;
+    }
+
+    report("Parse, QString::split()", count, timer.nsecsElapsed());
+
+    QList<QByteArray> latin1Strings;
+    latin1Strings.reserve(count);
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        latin1Strings.append(strings.at(i).toLatin1());
+    }
+
+    double sum = 0.0;
+    timer.start();
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        if (KExiv2::convertFromGPSCoordinateString(latin1Strings.at(i).constData(), latin1Strings.at(i).size(), &value))
+            sum += value;
+    }
+
+    report("Parse, char buffer", count, timer.nsecsElapsed());
+
+    timer.start();
+    const QList<double> values = KExiv2::convertFromGPSCoordinateStrings(strings);
+    report("Parse, batch", count, timer.nsecsElapsed());
+
+    // Rationals, for the altitudes written by the geotagging.
+
+    std::vector<double>   altitudes(count);
+    std::vector<long int> numerators(count);
+    std::vector<long int> denominators(count);
+    std::vector<long int> batchNumerators(count);
+    std::vector<long int> batchDenominators(count);
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        // Some whole values, which reduce to a denominator of 1.
+        altitudes[i] = (i % 16) ? QRandomGenerator::global()->bounded(9000.0) : (double)(i % 9000);
+    }
+
+    timer.start();
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        KExiv2::convertToRational(altitudes[i], &numerators[i], &denominators[i], 4);
+    }
+
+    report("Rational", count, timer.nsecsElapsed());
+
+    timer.start();
+    KExiv2::convertToRationals(altitudes.data(), batchNumerators.data(), batchDenominators.data(), count, 4);
+    report("Rational, batch", count, timer.nsecsElapsed());
+
+    int rationalMismatches = 0;
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        if (numerators[i] != batchNumerators[i] || denominators[i] != batchDenominators[i])
+        {
+            if (rationalMismatches < 10)
+            {
+                qDebug() << "Rational mismatch:" << altitudes[i] << numerators[i] << denominators[i]
+                         << batchNumerators[i] << batchDenominators[i];
+            }
+
+            ++rationalMismatches;
+        }
+    }
+
+    // Both implementations must give the same results.
+
+    int mismatches = 0;
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        double legacyValue = 0.0;
+        legacyFromGPSCoordinateString(legacyStrings.at(i), &legacyValue);
+
+        if (strings.at(i) != legacyStrings.at(i) || values.at(i) != legacyValue)
+        {
+            if (mismatches < 10)
+            {
+                qDebug() << "Mismatch:" << coordinates.at(i) << strings.at(i) << legacyStrings.at(i);
+            }
+
+            ++mismatches;
+        }
+    }
+
+    qDebug() << "Sums:" << legacySum << sum << "- characters:" << length << "- mismatches:" << mismatches
+             << "- rational mismatches:" << rationalMismatches;
+
+    return ((mismatches || rationalMismatches) ? 1 : 0);
+}
@@ -0,0 +1,126 @@
+/*
+    A command line tool to benchmark the spatial index over GPS positions
+
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Qt includes
+
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QString>
+#include <QVector>
+#include <QDebug>
+
+// Local includes
+
+#include "kexiv2gpsindex.h"
+
+using namespace KExiv2Iface;
+
+int main (int argc, char** argv)
+{
+    int count = 500000;
+
+    if (argc == 2)
+    {
+        count = QString::fromLocal8Bit(argv[1]).toInt();
+    }
+
+    if (count <= 0)
+    {
+        qDebug() << "benchgpsindex - benchmark the spatial index over GPS positions";
+        qDebug() << "Usage: [positions count]";
+        return -1;
+    }
+
+    // Half of the positions around a few places, as in a real collection, the others anywhere.
+
+    QRandomGenerator* const random = QRandomGenerator::global();
+    QVector<double> latitudes;
+    QVector<double> longitudes;
+    latitudes.reserve(count);
+    longitudes.reserve(count);
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        if (i % 2)
+        {
+            latitudes.append(random->bounded(180.0) - 90.0);
+            longitudes.append(random->bounded(360.0) - 180.0);
+        }
+        else
+        {
+            const int place = i % 5;
+            latitudes.append(-40.0 + place * 20.0 + random->bounded(1.0));
+            longitudes.append(-120.0 + place * 50.0 + random->bounded(1.0));
+        }
+    }
+
+    QElapsedTimer  timer;
+    KExiv2GPSIndex index;
+    timer.start();
+
+    for (int i = 0 ; i < count ; ++i)
+    {
+        index.add(i, latitudes.at(i), longitudes.at(i));
+    }
+
+    index.build();
+    qDebug() << "Index built in" << timer.elapsed() << "ms";
+
+    // Viewport queries, compared to a linear filtering.
+
+    const int queries = 1000;
+    qint64 found      = 0;
+    qint64 linear     = 0;
+    qint64 indexTime  = 0;
+    qint64 linearTime = 0;
+
+    for (int q = 0 ; q < queries ; ++q)
+    {
+        const double south = -40.0 + (q % 5) * 20.0 + random->bounded(0.5);
+        const double west  = -120.0 + (q % 5) * 50.0 + random->bounded(0.5);
+        const double north = south + 0.25;
+        const double east  = west  + 0.5;
+
+        timer.start();
+        found     += index.inBoundingBox(south, west, north, east).size();
+        indexTime += timer.nsecsElapsed();
+
+        timer.start();
+
+        for (int i = 0 ; i < count ; ++i)
+        {
+            if (latitudes.at(i) >= south && latitudes.at(i) <= north && longitudes.at(i) >= west && longitudes.at(i) <= east)
+            {
+                ++linear;
+            }
+        }
+
+        linearTime += timer.nsecsElapsed();
+    }
+
+    qDebug() << "Bounding box: index" << indexTime / queries / 1000 << "us, linear" << linearTime / queries / 1000
+             << "us per query -" << found << "/" << linear << "positions";
+
+    timer.start();
+
+    for (int q = 0 ; q < queries ; ++q)
+    {
+        found += index.nearest(random->bounded(180.0) - 90.0, random->bounded(360.0) - 180.0, 10).size();
+    }
+
+    qDebug() << "10 nearest neighbours:" << timer.nsecsElapsed() / queries / 1000 << "us per query";
+
+    for (int level = 0 ; level <= 12 ; level += 4)
+    {
+        timer.start();
+        const int clusters = index.clusters(level).size();
+        qDebug() << "Clusters at level" << level << ":" << clusters << "in" << timer.nsecsElapsed() / 1000 << "us";
+    }
+
+    return ((found > 0) ? 0 : 1);
+}
@@ -0,0 +1,81 @@
+/*
+    A command line tool to benchmark and check the Exif orientation kernels against QImage::transformed()
+
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Qt includes
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QRandomGenerator>
+#include <QString>
+#include <QDebug>
+
+// Local includes
+
+#include "kexiv2.h"
+#include "rotationmatrix.h"
+
+using namespace KExiv2Iface;
+
+int main (int argc, char** argv)
+{
+    int loops = 20;
+
+    if (argc == 2)
+    {
+        loops = QString::fromLocal8Bit(argv[1]).toInt();
+    }
+
+    if (loops <= 0)
+    {
+        qDebug() << "benchorientation - benchmark the Exif orientation kernels";
+        qDebug() << "Usage: [loops]";
+        return -1;
+    }
+
+    const QImage::Format formats[] = { QImage::Format_ARGB32, QImage::Format_Grayscale8, QImage::Format_RGB888 };
+    KExiv2 meta;
+    int    errors = 0;
+
+    for (const QImage::Format format : formats)
+    {
+        QImage image(1921, 1283, format);
+        QRandomGenerator::global()->fillRange(reinterpret_cast<quint32*>(image.bits()), image.sizeInBytes() / 4);
+
+        for (int orientation = KExiv2::ORIENTATION_HFLIP ; orientation <= KExiv2::ORIENTATION_LAST_VALUE ; ++orientation)
+        {
+            const KExiv2::ImageOrientation exifOrientation = (KExiv2::ImageOrientation)orientation;
+            QImage        reference;
+            QImage        output;
+            QElapsedTimer timer;
+            timer.start();
+
+            for (int i = 0 ; i < loops ; ++i)
+                reference = image.transformed(RotationMatrix::toTransform(exifOrientation));
+
+            const qint64 transformed = timer.nsecsElapsed();
+            timer.start();
+
+            for (int i = 0 ; i < loops ; ++i)
+                meta.rotateExifQImage(image, output, exifOrientation);
+
+            const qint64 kernel = timer.nsecsElapsed();
+
+            if (output != reference)
+            {
+                qDebug() << "Mismatch for format" << format << "orientation" << orientation;
+                ++errors;
+            }
+
+            qDebug() << "Format" << format << "orientation" << orientation << ":"
+                     << transformed / loops / 1000 << "us with QImage::transformed(),"
+                     << kernel / loops / 1000 << "us with the kernels";
+        }
+    }
+
+    return (errors ? 1 : 0);
+}
@@ -0,0 +1,116 @@
+/*
+    A command line tool to benchmark the decoding of JPEG comments, Exif user comments and IPTC strings
+
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Qt includes
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+#include <QDebug>
+
+// Local includes
+
+#include "kexiv2.h"
+
+using namespace KExiv2Iface;
+
+static void report(const char* const name, int loops, qint64 nsecs)
+{
+    qDebug() << name << ":" << (double)nsecs / loops << "ns per call";
+}
+
+int main (int argc, char** argv)
+{
+    int loops = 100000;
+
+    if (argc == 2)
+    {
+        loops = QString::fromLocal8Bit(argv[1]).toInt();
+    }
+
+    if (loops <= 0)
+    {
+        qDebug() << "benchtextdecoding - benchmark metadata text decoding";
+        qDebug() << "Usage: [loops]";
+        return -1;
+    }
+
+    const QString ascii = QString::fromLatin1("A news agency caption, long enough to be representative of real data. ").repeated(8);
+    const QString utf8  = QString::fromUtf8("Légende d'agence de presse, « Übersetzung » ニュース写真 キャプション. ").repeated(8);
+
+    KExiv2 meta;
+    QElapsedTimer timer;
+    int size = 0;
+
+    // JPEG comments, charset autodetection.
+
+    meta.setComments(ascii.toUtf8());
+    timer.start();
+
+    for (int i = 0 ; i < loops ; ++i)
+        size += meta.getCommentsDecoded().size();
+
+    report("JPEG comment, ASCII", loops, timer.nsecsElapsed());
+
+    meta.setComments(utf8.toUtf8());
+    timer.start();
+
+    for (int i = 0 ; i < loops ; ++i)
+        size += meta.getCommentsDecoded().size();
+
+    report("JPEG comment, UTF-8", loops, timer.nsecsElapsed());
+
+    meta.setComments(utf8.toLatin1());
+    timer.start();
+
+    for (int i = 0 ; i < loops ; ++i)
+        size += meta.getCommentsDecoded().size();
+
+    report("JPEG comment, 8 bits", loops, timer.nsecsElapsed());
+
+    // Exif user comments, charset header.
+
+    meta.setExifComment(ascii, false);
+    timer.start();
+
+    for (int i = 0 ; i < loops ; ++i)
+        size += meta.getExifComment().size();
+
+    report("Exif user comment, ASCII", loops, timer.nsecsElapsed());
+
+    meta.setExifComment(utf8, false);
+    timer.start();
+
+    for (int i = 0 ; i < loops ; ++i)
+        size += meta.getExifComment().size();
+
+    report("Exif user comment, Unicode", loops, timer.nsecsElapsed());
+
+    // IPTC strings.
+
+    meta.setIptcTagString("Iptc.Application2.Caption", ascii.left(2000), false);
+    timer.start();
+
+    for (int i = 0 ; i < loops ; ++i)
+        size += meta.getIptcTagString("Iptc.Application2.Caption").size();
+
+    report("IPTC caption", loops, timer.nsecsElapsed());
+
+    meta.setIptcKeywords(QStringList(), QStringList() << QString::fromUtf8("ニュース") << QString::fromLatin1("news")
+                                                      << QString::fromUtf8("Übersetzung"), false);
+    timer.start();
+
+    for (int i = 0 ; i < loops ; ++i)
+        size += meta.getIptcKeywords().size();
+
+    report("IPTC keywords", loops, timer.nsecsElapsed());
+
+    qDebug() << "Decoded" << size << "characters";
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+    A command line tool to geotag images with a GPX or NMEA track
+
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Qt includes
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QDebug>
+
+// Local includes
+
+#include "kexiv2.h"
+#include "kexiv2gpscorrelator.h"
+
+using namespace KExiv2Iface;
+
+int main (int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        qDebug() << "geotagfiles - geotag images with a GPS track";
+        qDebug() << "Usage: <track.gpx|track.nmea> <image> [<image> ...]";
+        return -1;
+    }
+
+    KExiv2::initializeExiv2();
+
+    const QString trackPath = QString::fromLocal8Bit(argv[1]);
+    QStringList   files;
+
+    for (int i = 2 ; i < argc ; ++i)
+    {
+        files << QString::fromLocal8Bit(argv[i]);
+    }
+
+    KExiv2GPSCorrelator correlator;
+    QElapsedTimer       timer;
+    timer.start();
+
+    const bool loaded = trackPath.endsWith(QLatin1String(".gpx"), Qt::CaseInsensitive) ? correlator.loadGPXFile(trackPath)
+                                                                                        : correlator.loadNMEAFile(trackPath);
+
+    if (!loaded)
+    {
+        qDebug() << "Cannot load track" << trackPath;
+        KExiv2::cleanupExiv2();
+        return -1;
+    }
+
+    qDebug() << "Track loaded with" << correlator.trackPointsCount() << "points in" << timer.elapsed() << "ms, from"
+             << correlator.firstDateTime() << "to" << correlator.lastDateTime();
+
+    QList<KExiv2GPSCorrelator::Match> matches;
+    timer.start();
+    const int count = correlator.geotagFiles(files, KExiv2::WRITETOIMAGEONLY, 0, &matches);
+
+    for (int i = 0 ; i < files.size() ; ++i)
+    {
+        const KExiv2GPSCorrelator::Match& match = matches.at(i);
+
+        if (match.isValid)
+        {
+            qDebug() << files.at(i) << ":" << match.latitude << match.longitude << match.altitude
+                     << (match.isInterpolated ? "interpolated" : "nearest point") << "gap:" << match.gap << "s";
+        }
+        else
+        {
+            qDebug() << files.at(i) << ": no match";
+        }
+    }
+
+    qDebug() << count << "files geotagged in" << timer.elapsed() << "ms";
+
+    KExiv2::cleanupExiv2();
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+    A command line tool to check the renaming of keywords holding path separators,
+    and of the parent keywords listed in Xmp.dc.subject
+
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Qt includes
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QDebug>
+
+// Local includes
+
+#include "kexiv2.h"
+#include "kexiv2keywordtree.h"
+
+using namespace KExiv2Iface;
+
+static bool check(const char* xmpTagName, const QStringList& values, const QStringList& expected)
+{
+    if (values == expected)
+        return true;
+
+    qDebug() << xmpTagName << "is" << values << "instead of" << expected;
+
+    return false;
+}
+
+int main (int /*argc*/, char** /*argv*/)
+{
+    KExiv2::initializeExiv2();
+
+    // Lightroom lists the parents of the keywords in dc:subject.
+
+    KExiv2 meta;
+    meta.setXmpTagStringBag("Xmp.lr.hierarchicalSubject",
+                            QStringList() << QString::fromLatin1("Music|AC/DC")
+                                          << QString::fromLatin1("Places|Paris"), false);
+    meta.setXmpTagStringBag("Xmp.dc.subject",
+                            QStringList() << QString::fromLatin1("AC/DC")
+                                          << QString::fromLatin1("Places")
+                                          << QString::fromLatin1("Paris"), false);
+
+    KExiv2KeywordTree tree;
+    QList<int>        names;
+    const QList<int>  keywords = tree.read(meta, &names);
+    const int         acdc     = tree.find(QString::fromLatin1("Music/AC\\/DC"));
+    const int         places   = tree.find(QString::fromLatin1("Places"));
+    bool              ok       = (keywords.size() == 2 && names.size() == 1 && acdc != -1 && places != -1);
+
+    if (!ok)
+    {
+        qDebug() << "Keywords" << keywords << "and names" << names << "not read";
+    }
+
+    ok = ok && tree.rename(acdc, QString::fromLatin1("AC|DC"));
+    ok = ok && tree.rename(places, QString::fromLatin1("Cities"));
+    ok = ok && tree.contains(keywords, acdc) && tree.contains(keywords, places);
+    ok = ok && tree.write(meta, keywords, names, false);
+
+    ok = ok && check("Xmp.lr.hierarchicalSubject", meta.getXmpTagStringBag("Xmp.lr.hierarchicalSubject", false),
+                     QStringList() << QString::fromLatin1("Music|AC\\|DC")
+                                   << QString::fromLatin1("Cities|Paris"));
+    ok = ok && check("Xmp.digiKam.TagsList", meta.getXmpTagStringSeq("Xmp.digiKam.TagsList", false),
+                     QStringList() << QString::fromLatin1("Music/AC|DC")
+                                   << QString::fromLatin1("Cities/Paris"));
+    ok = ok && check("Xmp.dc.subject", meta.getXmpTagStringBag("Xmp.dc.subject", false),
+                     QStringList() << QString::fromLatin1("AC|DC")
+                                   << QString::fromLatin1("Paris")
+                                   << QString::fromLatin1("Cities"));
+
+    // The written paths are read back to the same nodes.
+
+    const int count = tree.count();
+    ok              = ok && (tree.read(meta) == keywords) && (tree.count() == count);
+
+    qDebug() << (ok ? "Keywords renamed" : "Keywords not renamed");
+
+    KExiv2::cleanupExiv2();
+
+    return (ok ? 0 : -1);
+}
@@ -0,0 +1,59 @@
+/*
+    A command line tool to extract the thumbnails of many images in parallel
+
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Qt includes
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QDebug>
+
+// Local includes
+
+#include "kexiv2.h"
+#include "kexiv2thumbnailbatch.h"
+
+using namespace KExiv2Iface;
+
+int main (int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        qDebug() << "loadthumbnails - extract the thumbnails of images in parallel";
+        qDebug() << "Usage: <size> <image> [<image> ...]";
+        return -1;
+    }
+
+    KExiv2::initializeExiv2();
+
+    const int   size = QString::fromLocal8Bit(argv[1]).toInt();
+    QStringList files;
+
+    for (int i = 2 ; i < argc ; ++i)
+    {
+        files << QString::fromLocal8Bit(argv[i]);
+    }
+
+    KExiv2ThumbnailBatch batch;
+    batch.setDeliveryOrder(KExiv2ThumbnailBatch::PriorityOrder);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int count = batch.process(files, QSize(size, size),
+        [](const KExiv2ThumbnailBatch::Result& result)
+        {
+            qDebug() << result.index << result.filePath << result.thumbnail.size();
+        });
+
+    qDebug() << count << "thumbnails of" << files.size() << "files extracted in" << timer.elapsed() << "ms";
+
+    KExiv2::cleanupExiv2();
+
+    return 0;
+}
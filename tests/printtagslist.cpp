@@ -17,10 +17,24 @@
 
 using namespace KExiv2Iface;
 
-int main (int /*argc*/, char** /*argv*/)
+int main (int argc, char** argv)
 {
     KExiv2  meta;
 
+    if (argc == 2)
+    {
+        qDebug() << "-- Tags matching" << argv[1] << "---------------------------------------------------";
+        KExiv2::TagsMap found = meta.searchTagsList(QString::fromLocal8Bit(argv[1]), KExiv2::SUBSTRING_SEARCH);
+
+        for (KExiv2::TagsMap::const_iterator it = found.constBegin(); it != found.constEnd(); ++it )
+        {
+            QStringList values = it.value();
+            qDebug() << it.key() << " :: " << values[0] << " :: " << values[1];
+        }
+
+        return 0;
+    }
+
     qDebug() << "-- Standard Exif Tags -------------------------------------------------------------";
     KExiv2::TagsMap exiftags = meta.getStdExifTagsList();
 
@@ -0,0 +1,85 @@
+/*
+    A command line tool to rename a hierarchical keyword in many images
+
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Qt includes
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QDebug>
+
+// Local includes
+
+#include "kexiv2.h"
+#include "kexiv2keywordtree.h"
+
+using namespace KExiv2Iface;
+
+int main (int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        qDebug() << "renamekeyword - rename a hierarchical keyword in images";
+        qDebug() << "Usage: <keyword path> <new name> <image> [<image> ...]";
+        return -1;
+    }
+
+    KExiv2::initializeExiv2();
+
+    const QString     path    = QString::fromLocal8Bit(argv[1]);
+    const QString     newName = QString::fromLocal8Bit(argv[2]);
+    QStringList       files;
+    QList<QList<int>> keywords;
+    QList<QList<int>> names;
+    KExiv2KeywordTree tree;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 3 ; i < argc ; ++i)
+    {
+        KExiv2 meta;
+        meta.load(QString::fromLocal8Bit(argv[i]));
+        files    << QString::fromLocal8Bit(argv[i]);
+        names    << QList<int>();
+        keywords << tree.read(meta, &names.last());
+    }
+
+    qDebug() << tree.count() << "keywords read from" << files.size() << "files in" << timer.restart() << "ms";
+
+    const int node = tree.find(path);
+
+    if (node == -1 || !tree.rename(node, newName))
+    {
+        qDebug() << "Cannot rename" << path << "to" << newName;
+        KExiv2::cleanupExiv2();
+        return -1;
+    }
+
+    int written = 0;
+
+    for (int i = 0 ; i < files.size() ; ++i)
+    {
+        if (!tree.contains(keywords.at(i), node))
+            continue;
+
+        KExiv2 meta;
+
+        if (meta.load(files.at(i)) && tree.write(meta, keywords.at(i), names.at(i)) && meta.applyChanges())
+        {
+            ++written;
+        }
+    }
+
+    qDebug() << written << "files written in" << timer.elapsed() << "ms";
+
+    KExiv2::cleanupExiv2();
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+    A command line tool to set, rename or remove the MWG face regions of an image
+
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Qt includes
+
+#include <QList>
+#include <QRectF>
+#include <QString>
+#include <QDebug>
+
+// Local includes
+
+#include "kexiv2.h"
+
+using namespace KExiv2Iface;
+
+int main (int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        qDebug() << "setfaceregions - set, rename or remove the face regions of an image";
+        qDebug() << "Usage: <add/rename/remove> <image>";
+        return -1;
+    }
+
+    const QString op       = QString::fromLatin1(argv[1]);
+    const QString filePath = QString::fromLocal8Bit(argv[2]);
+
+    KExiv2::initializeExiv2();
+
+    KExiv2 meta;
+    meta.load(filePath);
+    meta.setWriteRawFiles(true);
+
+    QList<KExiv2::FaceRegion> regions;
+
+    if (op == QString::fromLatin1("add"))
+    {
+        // Keep the current regions, and append two new ones.
+
+        regions = meta.getFaceRegions();
+
+        KExiv2::FaceRegion face;
+        face.type = QString::fromLatin1("Face");
+        face.name = QString::fromLatin1("Bob Marley");
+        face.area = QRectF(0.4, 0.4, 0.2, 0.2);
+        regions << face;
+
+        face.name = QString::fromLatin1("Hello Kitty!");
+        face.area = QRectF(0.1, 0.1, 0.3, 0.3);
+        regions << face;
+    }
+    else if (op == QString::fromLatin1("rename"))
+    {
+        // The fields which are not read, as the descriptions, are kept.
+
+        regions = meta.getFaceRegions();
+
+        for (KExiv2::FaceRegion& region : regions)
+        {
+            region.name = region.name.toUpper();
+        }
+    }
+
+    meta.setFaceRegions(regions, false);
+    meta.applyChanges();
+
+    KExiv2 meta2;
+    meta2.load(filePath);
+
+    for (const KExiv2::FaceRegion& region : meta2.getFaceRegions())
+    {
+        qDebug() << "Saved region:" << region.name << region.type << region.area;
+    }
+
+    KExiv2::cleanupExiv2();
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+    A command line tool to check the composition of the orientations and the
+    transformation of the MWG regions for all Exif orientations
+
+    SPDX-FileCopyrightText: 2026 agent <agent at local>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// C++ includes
+
+#include <cmath>
+
+// Qt includes
+
+#include <QList>
+#include <QRectF>
+#include <QString>
+#include <QTransform>
+#include <QDebug>
+
+// Local includes
+
+#include "kexiv2.h"
+#include "rotationmatrix.h"
+
+using namespace KExiv2Iface;
+
+static bool fuzzyCompare(const QRectF& a, const QRectF& b)
+{
+    return (fabs(a.x()      - b.x())      < 1e-6 &&
+            fabs(a.y()      - b.y())      < 1e-6 &&
+            fabs(a.width()  - b.width())  < 1e-6 &&
+            fabs(a.height() - b.height()) < 1e-6);
+}
+
+/** Returns a normalized area moved as the pixels of the image, around its center.
+ */
+static QRectF expectedArea(const QRectF& area, KExiv2::ImageOrientation orientation)
+{
+    return RotationMatrix::toTransform(orientation).mapRect(area.translated(-0.5, -0.5)).translated(0.5, 0.5);
+}
+
+/** Sets one face region in \a meta, and the dimensions it applies to.
+ */
+static void setRegion(KExiv2& meta, const QRectF& area)
+{
+    KExiv2::FaceRegion face;
+    face.type = QString::fromLatin1("Face");
+    face.name = QString::fromLatin1("Bob Marley");
+    face.area = area;
+
+    meta.setFaceRegions(QList<KExiv2::FaceRegion>() << face, false);
+    meta.setXmpTagString("Xmp.mwg-rs.Regions/mwg-rs:AppliedToDimensions/stDim:w", QString::fromLatin1("400"), false);
+    meta.setXmpTagString("Xmp.mwg-rs.Regions/mwg-rs:AppliedToDimensions/stDim:h", QString::fromLatin1("300"), false);
+}
+
+static QRectF regionArea(const KExiv2& meta)
+{
+    const QList<KExiv2::FaceRegion> regions = meta.getFaceRegions();
+
+    return (regions.size() == 1 ? regions.first().area : QRectF());
+}
+
+int main (int /*argc*/, char** /*argv*/)
+{
+    KExiv2::initializeExiv2();
+
+    int failures = 0;
+
+    // The composition table must match the products of the matrices.
+
+    for (int a = KExiv2::ORIENTATION_UNSPECIFIED ; a <= KExiv2::ORIENTATION_LAST_VALUE ; ++a)
+    {
+        for (int b = KExiv2::ORIENTATION_UNSPECIFIED ; b <= KExiv2::ORIENTATION_LAST_VALUE ; ++b)
+        {
+            RotationMatrix product((KExiv2::ImageOrientation)a);
+            product *= (KExiv2::ImageOrientation)b;
+
+            const KExiv2::ImageOrientation combined = RotationMatrix::combine((KExiv2::ImageOrientation)a,
+                                                                              (KExiv2::ImageOrientation)b);
+
+            if (combined != product.exifOrientation())
+            {
+                qDebug() << "combine(" << a << "," << b << ") is" << combined << "instead of" << product.exifOrientation();
+                ++failures;
+            }
+        }
+    }
+
+    // The regions must move as the pixels, and transforming them twice must give the
+    // same areas as once with the combined orientation.
+
+    const QRectF area(0.2, 0.3, 0.1, 0.2);
+
+    for (int a = KExiv2::ORIENTATION_NORMAL ; a <= KExiv2::ORIENTATION_LAST_VALUE ; ++a)
+    {
+        const KExiv2::ImageOrientation orientation = (KExiv2::ImageOrientation)a;
+        KExiv2                         meta;
+        setRegion(meta, area);
+
+        if (!meta.transformXmpRegions(orientation, false))
+        {
+            qDebug() << "Cannot transform the regions with orientation" << a;
+            ++failures;
+        }
+
+        const QRectF expected   = expectedArea(area, orientation);
+        const bool   transposed = (a >= KExiv2::ORIENTATION_ROT_90_HFLIP);
+        const QString width     = meta.getXmpTagString("Xmp.mwg-rs.Regions/mwg-rs:AppliedToDimensions/stDim:w", false);
+
+        if (!fuzzyCompare(regionArea(meta), expected))
+        {
+            qDebug() << "Orientation" << a << ": area" << regionArea(meta) << "instead of" << expected;
+            ++failures;
+        }
+
+        if (width != QString::fromLatin1(transposed ? "300" : "400"))
+        {
+            qDebug() << "Orientation" << a << ": width" << width;
+            ++failures;
+        }
+
+        for (int b = KExiv2::ORIENTATION_NORMAL ; b <= KExiv2::ORIENTATION_LAST_VALUE ; ++b)
+        {
+            KExiv2 twice;
+            KExiv2 once;
+            setRegion(twice, area);
+            setRegion(once, area);
+
+            twice.transformXmpRegions(orientation, false);
+            twice.transformXmpRegions((KExiv2::ImageOrientation)b, false);
+            once.transformXmpRegions(RotationMatrix::combine((KExiv2::ImageOrientation)b, orientation), false);
+
+            if (!fuzzyCompare(regionArea(twice), regionArea(once)))
+            {
+                qDebug() << "Orientations" << a << "then" << b << ":" << regionArea(twice)
+                         << "instead of" << regionArea(once);
+                ++failures;
+            }
+        }
+    }
+
+    qDebug() << failures << "failures";
+
+    KExiv2::cleanupExiv2();
+
+    return (failures ? 1 : 0);
+}